@@ -9,6 +9,7 @@ mkdir ./build/interrupt_descriptor_table
 mkdir ./build/interrupt_service_routines
 mkdir ./build/memory
 mkdir ./build/malloc
+mkdir ./build/pmm
 mkdir ./build/paging
 mkdir ./build/io
 mkdir ./build/disk
@@ -7,6 +7,8 @@ void *malloc(size_t size);
 
 void free(void *ptr);
 
+void *realloc(void *ptr, size_t size);
+
 char *itoa(int i);
 
 char *itoa_hex(int i);
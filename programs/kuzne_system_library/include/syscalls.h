@@ -16,14 +16,36 @@ struct ProcessArguments
     char** argv;
 };
 
+#define HEAP_STATS_HISTOGRAM_BUCKETS 16
+
+// Kernel heap snapshot in 4KB blocks, same layout as the kernel's struct KernelHeapStats.
+struct HeapStats
+{
+    unsigned int total_blocks;
+    unsigned int used_blocks;
+    unsigned int free_blocks;
+    unsigned int peak_used_blocks;
+    unsigned int largest_free_run;
+    unsigned int free_runs[HEAP_STATS_HISTOGRAM_BUCKETS]; // 1, 2-3, 4-7 ... blocks
+    unsigned int allocations;
+    unsigned int frees;
+    unsigned int zero_pool_blocks;
+    unsigned int zero_pool_hits;
+    unsigned int zero_pool_misses;
+};
+
 extern void kuzne_syscall_print(const char* filename);
 
 extern int kuzne_syscall_getkey();
 
+// Kernel heap memory, a fork child can't access it. malloc's heap is inherited.
 extern void* kuzne_syscall_malloc(size_t size);
 
 extern void kuzne_syscall_free(void* ptr);
 
+// Resizes kuzne_syscall_malloc memory, in place when the kernel heap allows. 0 on failure, ptr stays valid.
+extern void* kuzne_syscall_realloc(void* ptr, size_t size);
+
 extern void kuzne_syscall_putchar(char c);
 
 extern int kuzne_getkeyblock();
@@ -42,4 +64,30 @@ extern int kuzne_system_run(const char* command);
 
 extern void kuzne_syscall_exit();
 
+extern void kuzne_syscall_heap_stats(struct HeapStats* stats);
+
+// Returns the previous end of the user heap, 0 when it can't move.
+extern void* kuzne_syscall_sbrk(int increment);
+
+// Copies the current process copy-on-write. The child's process id to the parent, 0 to the child, negative on error.
+// The child sees the parent's program arguments and malloc heap at the same addresses.
+extern int kuzne_syscall_fork();
+
+// Creates a zeroed shared memory segment of size bytes, its id or a negative error. Any process can map it by id.
+extern int kuzne_syscall_shm_create(size_t size);
+
+// Maps a shared memory segment, its address or 0 on failure. Forks keep it shared.
+extern void* kuzne_syscall_shm_map(int segment);
+
+// Unmaps a segment at the address kuzne_syscall_shm_map returned. It lives until its creator exited and no mapping
+// is left.
+extern int kuzne_syscall_shm_unmap(void* address);
+
+// Maps a whole file read only (e.g. "0:/data.bin"), its address or 0 on failure. Pages are read on first access and
+// shared with every other mapping of the file, writes end the program.
+extern void* kuzne_syscall_mmap(const char* path);
+
+// Unmaps a file at the address kuzne_syscall_mmap returned.
+extern int kuzne_syscall_munmap(void* address);
+
 #endif
\ No newline at end of file
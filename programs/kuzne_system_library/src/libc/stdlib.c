@@ -1,5 +1,6 @@
 #include "../../include/stdlib.h"
 #include "../../include/syscalls.h"
+#include "../../include/memory.h"
 
 char* itoa(int i)
 {
@@ -83,12 +84,281 @@ char* ptr_to_hex(const unsigned long ptr)
     return &text[loc];
 }
 
+/*
+malloc keeps its own chunks in the user heap and only enters the kernel (sbrk) when the heap has to grow.
+
+Every chunk starts with a 16 byte header holding its total size, the payload follows 16 byte aligned.
+Chunks of up to MALLOC_MAX_SMALL_CHUNK bytes come in power-of-two size classes with one free list each,
+larger chunks are rounded to 16 bytes and kept on a first-fit list when freed. A free large chunk is split when
+it is bigger than the request and merges with free large neighbours, or goes back to the top of the heap.
+Free large chunks keep their size in their last word too, so the chunk above can find them.
+*/
+
+#define MALLOC_MIN_CHUNK 32
+#define MALLOC_SIZE_CLASSES 7
+#define MALLOC_MAX_SMALL_CHUNK (MALLOC_MIN_CHUNK << (MALLOC_SIZE_CLASSES - 1)) // 2048
+#define MALLOC_ALIGNMENT 16
+#define MALLOC_SBRK_STEP 16384 // The heap grows at least this much per sbrk
+
+// Low bits of MallocChunk.size, chunk sizes are multiples of MALLOC_ALIGNMENT.
+#define MALLOC_CHUNK_FREE 0x1      // Large chunk on the large free list
+#define MALLOC_CHUNK_PREV_FREE 0x2 // The chunk right below is a free large chunk
+#define MALLOC_CHUNK_FLAGS (MALLOC_CHUNK_FREE | MALLOC_CHUNK_PREV_FREE)
+
+struct MallocChunk
+{
+    size_t size;              // Total chunk size, header included, plus MALLOC_CHUNK_ flags
+    struct MallocChunk* next; // Free list links while the chunk is free
+    struct MallocChunk* prev;
+    size_t unused;            // Pads the header to MALLOC_ALIGNMENT
+};
+
+static struct MallocChunk* MALLOC_FREE_LISTS_[MALLOC_SIZE_CLASSES];
+static struct MallocChunk* MALLOC_LARGE_FREE_LIST_;
+
+// Unused part of the heap between the last carved chunk and the break. A chunk right below the top is never free.
+static char* MALLOC_TOP_ = 0;
+static char* MALLOC_TOP_END_ = 0;
+
+static int malloc_size_class(size_t chunk_size)
+{
+    int i = 0;
+    while ((size_t)(MALLOC_MIN_CHUNK << i) < chunk_size)
+    {
+        i++;
+    }
+
+    return i;
+}
+
+static size_t malloc_chunk_size(struct MallocChunk* chunk)
+{
+    return chunk->size & ~MALLOC_CHUNK_FLAGS;
+}
+
+// Chunk right above, 0 when the top of the heap is.
+static struct MallocChunk* malloc_next_chunk(struct MallocChunk* chunk)
+{
+    char* next = (char*)chunk + malloc_chunk_size(chunk);
+    return next == MALLOC_TOP_ ? 0 : (struct MallocChunk*)next;
+}
+
+static struct MallocChunk* malloc_carve(size_t chunk_size)
+{
+    // The top always keeps room for a header, so a top left behind by a foreign sbrk can be fenced off.
+    if ((size_t)(MALLOC_TOP_END_ - MALLOC_TOP_) < chunk_size + sizeof(struct MallocChunk))
+    {
+        size_t need = chunk_size + sizeof(struct MallocChunk) + MALLOC_ALIGNMENT;
+        size_t grow = need > MALLOC_SBRK_STEP ? need : MALLOC_SBRK_STEP;
+        char* old_break = kuzne_syscall_sbrk(grow);
+        if (!old_break)
+        {
+            return 0;
+        }
+
+        // Only malloc moves the break, so the new memory normally continues the current top. Otherwise the old top
+        // becomes a chunk that is never freed, the chunk below it must not run into foreign memory.
+        if (old_break != MALLOC_TOP_END_)
+        {
+            if (MALLOC_TOP_)
+            {
+                ((struct MallocChunk*)MALLOC_TOP_)->size = MALLOC_TOP_END_ - MALLOC_TOP_;
+            }
+            MALLOC_TOP_ = (char*)(((size_t)old_break + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1));
+        }
+        MALLOC_TOP_END_ = old_break + grow;
+    }
+
+    struct MallocChunk* chunk = (struct MallocChunk*)MALLOC_TOP_;
+    MALLOC_TOP_ += chunk_size;
+    chunk->size = chunk_size;
+    return chunk;
+}
+
+// Marks a large chunk free and puts it on the large free list.
+static void malloc_large_push(struct MallocChunk* chunk, size_t chunk_size)
+{
+    chunk->size = chunk_size | MALLOC_CHUNK_FREE;
+    *(size_t*)((char*)chunk + chunk_size - sizeof(size_t)) = chunk_size;
+    malloc_next_chunk(chunk)->size |= MALLOC_CHUNK_PREV_FREE;
+
+    chunk->prev = 0;
+    chunk->next = MALLOC_LARGE_FREE_LIST_;
+    if (chunk->next)
+    {
+        chunk->next->prev = chunk;
+    }
+    MALLOC_LARGE_FREE_LIST_ = chunk;
+}
+
+static void malloc_large_unlink(struct MallocChunk* chunk)
+{
+    if (chunk->prev)
+    {
+        chunk->prev->next = chunk->next;
+    }
+    else
+    {
+        MALLOC_LARGE_FREE_LIST_ = chunk->next;
+    }
+
+    if (chunk->next)
+    {
+        chunk->next->prev = chunk->prev;
+    }
+}
+
+static struct MallocChunk* malloc_take_large(size_t chunk_size)
+{
+    struct MallocChunk* chunk = MALLOC_LARGE_FREE_LIST_;
+    while (chunk && malloc_chunk_size(chunk) < chunk_size)
+    {
+        chunk = chunk->next;
+    }
+
+    if (!chunk)
+    {
+        return malloc_carve(chunk_size);
+    }
+
+    // Free chunks are never next to each other or to the top, so both neighbours are in use.
+    malloc_large_unlink(chunk);
+    size_t remainder = malloc_chunk_size(chunk) - chunk_size;
+    if (remainder >= MALLOC_MIN_CHUNK)
+    {
+        chunk->size = chunk_size;
+        malloc_large_push((struct MallocChunk*)((char*)chunk + chunk_size), remainder);
+        return chunk;
+    }
+
+    chunk->size = malloc_chunk_size(chunk);
+    malloc_next_chunk(chunk)->size &= ~MALLOC_CHUNK_PREV_FREE;
+    return chunk;
+}
+
+static void malloc_free_large(struct MallocChunk* chunk)
+{
+    size_t chunk_size = malloc_chunk_size(chunk);
+    if (chunk->size & MALLOC_CHUNK_PREV_FREE)
+    {
+        size_t prev_size = *(size_t*)((char*)chunk - sizeof(size_t));
+        chunk = (struct MallocChunk*)((char*)chunk - prev_size);
+        malloc_large_unlink(chunk);
+        chunk_size += prev_size;
+    }
+
+    char* next = (char*)chunk + chunk_size;
+    if (next == MALLOC_TOP_)
+    {
+        MALLOC_TOP_ = (char*)chunk;
+        return;
+    }
+
+    if (((struct MallocChunk*)next)->size & MALLOC_CHUNK_FREE)
+    {
+        malloc_large_unlink((struct MallocChunk*)next);
+        chunk_size += malloc_chunk_size((struct MallocChunk*)next);
+    }
+
+    malloc_large_push(chunk, chunk_size);
+}
+
 void* malloc(size_t size)
 {
-    return kuzne_syscall_malloc(size);
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    size_t chunk_size = size + sizeof(struct MallocChunk);
+    struct MallocChunk* chunk = 0;
+
+    if (chunk_size <= MALLOC_MAX_SMALL_CHUNK)
+    {
+        int size_class = malloc_size_class(chunk_size);
+        chunk = MALLOC_FREE_LISTS_[size_class];
+        if (chunk)
+        {
+            MALLOC_FREE_LISTS_[size_class] = chunk->next;
+        }
+        else
+        {
+            chunk = malloc_carve(MALLOC_MIN_CHUNK << size_class);
+        }
+    }
+    else
+    {
+        chunk_size = (chunk_size + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1);
+        chunk = malloc_take_large(chunk_size);
+    }
+
+    if (!chunk)
+    {
+        return 0;
+    }
+
+    return (char*)chunk + sizeof(struct MallocChunk);
 }
 
 void free(void* ptr)
 {
-    kuzne_syscall_free(ptr);
-}
\ No newline at end of file
+    if (!ptr)
+    {
+        return;
+    }
+
+    struct MallocChunk* chunk = (struct MallocChunk*)((char*)ptr - sizeof(struct MallocChunk));
+    if (malloc_chunk_size(chunk) <= MALLOC_MAX_SMALL_CHUNK)
+    {
+        int size_class = malloc_size_class(malloc_chunk_size(chunk));
+        chunk->next = MALLOC_FREE_LISTS_[size_class];
+        MALLOC_FREE_LISTS_[size_class] = chunk;
+        return;
+    }
+
+    malloc_free_large(chunk);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return malloc(size);
+    }
+
+    if (size == 0)
+    {
+        free(ptr);
+        return 0;
+    }
+
+    struct MallocChunk* chunk = (struct MallocChunk*)((char*)ptr - sizeof(struct MallocChunk));
+    size_t capacity = malloc_chunk_size(chunk) - sizeof(struct MallocChunk);
+    if (size <= capacity)
+    {
+        return ptr;
+    }
+
+    // A large chunk right below the top grows in place into the unused top of the heap.
+    size_t chunk_size = (size + sizeof(struct MallocChunk) + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1);
+    if (malloc_chunk_size(chunk) > MALLOC_MAX_SMALL_CHUNK && !malloc_next_chunk(chunk))
+    {
+        // The top only moves elsewhere if something besides malloc moved the break, the piece is lost then.
+        struct MallocChunk* extension = malloc_carve(chunk_size - malloc_chunk_size(chunk));
+        if (extension == (struct MallocChunk*)((char*)chunk + malloc_chunk_size(chunk)))
+        {
+            chunk->size = chunk_size | (chunk->size & MALLOC_CHUNK_PREV_FREE);
+            return ptr;
+        }
+    }
+
+    void* new_ptr = malloc(size);
+    if (!new_ptr)
+    {
+        return 0;
+    }
+
+    memcpy(new_ptr, ptr, capacity);
+    free(ptr);
+    return new_ptr;
+}
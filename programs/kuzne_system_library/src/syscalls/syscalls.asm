@@ -11,6 +11,15 @@ global kuzne_syscall_process_load_start:function
 global kuzne_syscall_process_get_arguments:function 
 global kuzne_syscall_system:function
 global kuzne_syscall_exit:function
+global kuzne_syscall_heap_stats:function
+global kuzne_syscall_sbrk:function
+global kuzne_syscall_realloc:function
+global kuzne_syscall_fork:function
+global kuzne_syscall_shm_create:function
+global kuzne_syscall_shm_map:function
+global kuzne_syscall_shm_unmap:function
+global kuzne_syscall_mmap:function
+global kuzne_syscall_munmap:function
 
 ; void kuzne_syscall_print(const char* filename)
 kuzne_syscall_print:
@@ -106,4 +115,102 @@ kuzne_syscall_exit:
     mov eax, 9 ; Command 9 process exit
     int 0x80    ; trigger interrupt 0x80
     pop ebp
-    ret
\ No newline at end of file
+    ret
+
+; void kuzne_syscall_heap_stats(struct HeapStats* stats)
+kuzne_syscall_heap_stats:
+    push ebp
+    mov ebp, esp
+    mov eax, 10 ; Command 10 kernel heap statistics
+    push dword[ebp+8] ; Variable "stats"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; void* kuzne_syscall_sbrk(int increment)
+kuzne_syscall_sbrk:
+    push ebp
+    mov ebp, esp
+    mov eax, 11 ; Command 11 sbrk ( moves the end of the user heap )
+    push dword[ebp+8] ; Variable "increment"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; void* kuzne_syscall_realloc(void* ptr, size_t size)
+kuzne_syscall_realloc:
+    push ebp
+    mov ebp, esp
+    mov eax, 12 ; Command 12 realloc ( resizes kuzne_syscall_malloc memory )
+    push dword[ebp+12] ; Variable "size"
+    push dword[ebp+8] ; Variable "ptr"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 8
+    pop ebp
+    ret
+
+; int kuzne_syscall_fork()
+kuzne_syscall_fork:
+    push ebp
+    mov ebp, esp
+    mov eax, 13 ; Command 13 fork ( copies the current process )
+    int 0x80    ; trigger interrupt 0x80
+    pop ebp
+    ret
+
+; int kuzne_syscall_shm_create(size_t size)
+kuzne_syscall_shm_create:
+    push ebp
+    mov ebp, esp
+    mov eax, 14 ; Command 14 shm_create ( creates a shared memory segment )
+    push dword[ebp+8] ; Variable "size"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; void* kuzne_syscall_shm_map(int segment)
+kuzne_syscall_shm_map:
+    push ebp
+    mov ebp, esp
+    mov eax, 15 ; Command 15 shm_map ( maps a shared memory segment )
+    push dword[ebp+8] ; Variable "segment"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; int kuzne_syscall_shm_unmap(void* address)
+kuzne_syscall_shm_unmap:
+    push ebp
+    mov ebp, esp
+    mov eax, 16 ; Command 16 shm_unmap ( unmaps a shared memory segment )
+    push dword[ebp+8] ; Variable "address"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; void* kuzne_syscall_mmap(const char* path)
+kuzne_syscall_mmap:
+    push ebp
+    mov ebp, esp
+    mov eax, 17 ; Command 17 mmap ( maps a file read only )
+    push dword[ebp+8] ; Variable "path"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
+
+; int kuzne_syscall_munmap(void* address)
+kuzne_syscall_munmap:
+    push ebp
+    mov ebp, esp
+    mov eax, 18 ; Command 18 munmap ( unmaps a mapped file )
+    push dword[ebp+8] ; Variable "address"
+    int 0x80    ; trigger interrupt 0x80
+    add esp, 4
+    pop ebp
+    ret
@@ -4,6 +4,26 @@
 #include "stdlib.h"
 #include "syscalls.h"
 
+static void shell_print_heap_stats()
+{
+    struct HeapStats stats;
+    kuzne_syscall_heap_stats(&stats);
+
+    printf("blocks: %i used, %i free, %i total, %i peak\n", stats.used_blocks, stats.free_blocks, stats.total_blocks,
+           stats.peak_used_blocks);
+    printf("largest free run: %i\n", stats.largest_free_run);
+    printf("allocations: %i, frees: %i\n", stats.allocations, stats.frees);
+    printf("zero pool: %i blocks, %i hits, %i misses\n", stats.zero_pool_blocks, stats.zero_pool_hits,
+           stats.zero_pool_misses);
+
+    print("free runs:");
+    for (int i = 0; i < HEAP_STATS_HISTOGRAM_BUCKETS; i++)
+    {
+        printf(" %i", stats.free_runs[i]);
+    }
+    print("\n");
+}
+
 int main(int argc, char** argv)
 {
     println("Shell v1.0.0");
@@ -24,6 +44,12 @@ int main(int argc, char** argv)
             break;
         }
 
+        if (strncmp(buffer, "heap", 4) == 0)
+        {
+            print("\n");
+            shell_print_heap_stats();
+        }
+
         if (strncmp(buffer, "run ", 4) == 0)
         {
             print("\n");
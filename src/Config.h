@@ -20,8 +20,41 @@
 #define TOTAL_GDT_SEGMENTS 6
 
 
+// Share of the free physical frames reserved for the kernel heap at boot, the rest stays with the PMM.
+#define KERNEL_HEAP_RAM_PERCENT 50
+
+// Kernel heap allocation policy, see malloc/Heap.h. Compare policies with tools/heap_bench before changing it, buddy
+// fails far more allocations than first-fit once the heap holds mixed run sizes.
+#define KERNEL_HEAP_POLICY HEAP_POLICY_FIRST_FIT
+// HEAP_MAP_ENCODING_BITMAP needs a policy other than HEAP_POLICY_BUDDY
+#define KERNEL_HEAP_MAP_ENCODING HEAP_MAP_ENCODING_BITMAP
+
+// kernel_malloc serves 16 to 2048 byte requests from slab size classes, see malloc/Slab.h
+#define KERNEL_SLAB_SIZE_CLASSES 8
+#define KERNEL_SLAB_MAX_SIZE 2048
+
+// Pre-zeroed 4KB blocks kept for kernel_zeroed_page_alloc, refilled while the system idles
+#define KERNEL_ZERO_POOL_SIZE 64
+#define KERNEL_ZERO_POOL_IDLE_REFILL 4  // blocks zeroed per idle getkey poll
+
+// Uncomment to record kernel heap allocations and frees in a ring buffer, see kernel_heap_trace_dump
+// #define KERNEL_HEAP_TRACE
+#define KERNEL_HEAP_TRACE_SIZE 256
+
+
+// Page ranges longer than this are dropped from the TLB with one full flush instead of an invlpg per page
+#define PAGING_INVALIDATE_MAX_PAGES 32
+
+
+// Per-task scratch arena for path lookups, directory walks and ELF headers, see malloc/Arena.h
+#define KERNEL_SCRATCH_ARENA_SIZE 65536
+
+
 #define MAX_PROGRAM_ALLOCATIONS 1024
 #define MAX_PROCESSES 12
+#define MAX_PROCESS_REGIONS 16 // Demand paged regions per process, see ProcessRegion
+#define MAX_SHM_SEGMENTS 32 // Shared memory segments system wide, see process/Shm.h
+#define MAX_PAGE_CACHE_FILES 16 // Files mapped at once system wide, see fs/PageCache.h
 
 
 #define USER_DATA_SEGMENT 0x23
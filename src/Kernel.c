@@ -11,12 +11,15 @@
 #include "io/Io.h"
 #include "keyboard/Keyboard.h"
 #include "malloc/Kheap.h"
+#include "malloc/Vmalloc.h"
 #include "memory/Memory.h"
 #include "paging/Paging.h"
+#include "pmm/Pmm.h"
 #include "process/Process.h"
 #include "process/Task.h"
 #include "process/Tss.h"
 #include "vga/Vga.h"
+#include <stdbool.h>
 
 /*
 https://wiki.osdev.org/Detecting_Memory_(x86)
@@ -26,14 +29,17 @@ It also saves the current state of the CR0 register and invalidates the cache to
 
 This function enters a loop where it increments the memory address by 1MB steps.
 For each step, it writes a test pattern (0x55AA55AA) to the memory location and verifies it.
-If the memory location can store and return the correct value, it increments the memory count.
+If the memory location can store and return the correct value, the next 1MB step is tested.
 If not, it assumes the end of available memory has been reached.
+
+Runs before paging is enabled, probing stops at PMM_MAX_MEMORY_END to stay clear of the PCI/APIC hole.
+Returns the end address of contiguous RAM, which is also the size in bytes.
 */
-static void probe_8gb_memory_count(void)
+static uint32_t probe_memory_end(void)
 {
     uint32_t* mem;
-    uint32_t mem_count = 0, a;
-    uint16_t memkb = 0;
+    uint32_t mem_end = 1024 * 1024, a;
+    bool found;
     uint8_t irq1, irq2;
     uint32_t cr0;
 
@@ -56,41 +62,42 @@ static void probe_8gb_memory_count(void)
 
     do
     {
-        memkb++;
-        mem_count += 1024 * 1024;
-        mem = (uint32_t*)mem_count;
+        // Memory below 1MB holds the BIOS ROM, the first step tested is 1MB.
+        mem = (uint32_t*)mem_end;
 
         a = *mem;
         *mem = 0x55AA55AA;
         __asm__ __volatile__("" ::: "memory");
 
-        if (*mem != 0x55AA55AA)
-            mem_count = 0;
-        else
+        found = *mem == 0x55AA55AA;
+        if (found)
         {
             *mem = 0xAA55AA55;
             __asm__ __volatile__("" ::: "memory");
-            if (*mem != 0xAA55AA55) mem_count = 0;
+            found = *mem == 0xAA55AA55;
         }
 
         __asm__ __volatile__("" ::: "memory");
         *mem = a;
 
-    } while (memkb < 8192 && mem_count != 0);  // 8192 MB => 8GB
+        if (found)
+        {
+            mem_end += 1024 * 1024;
+        }
+
+    } while (found && mem_end < PMM_MAX_MEMORY_END);
 
     // Restore CR0
     __asm__ __volatile__("movl %%eax, %%cr0" ::"a"(cr0));
 
-    uint32_t mem_end = memkb << 20;
-
     // Restore IRQs
     outb(0x21, irq1);
     outb(0xA1, irq2);
 
-    logAddress("total memory in bytes: ", mem_end);  // 0x20000000
+    // 1GB of RAM, the addresses range is from 0x00000000 to 0x3FFFFFFF
+    logAddress("End memory address: ", mem_end);  // 0x40000000
 
-    // 512MB of RAM, the addresses range is from 0x00000000 to 0x1FFFFFFF
-    logAddress("End memory address: ", mem_end);  // 0x20000000
+    return mem_end;
 }
 
 static struct PageDirectory* KERNEL_PAGE_DIRECTORY_ = 0;
@@ -130,6 +137,9 @@ void kernel_main()
     // Load the gdt
     gdt_load(GDT_REAL_, sizeof(GDT_REAL_));
 
+    // Size physical memory before anything allocates from it
+    pmm_init(probe_memory_end());
+
     // Initialize the heap
     kernel_heap_init();
 
@@ -150,9 +160,11 @@ void kernel_main()
     // Load the TSS
     tss_load(0x28);
 
-    // allocate page directory for the kernel
-    KERNEL_PAGE_DIRECTORY_ =
-        new_page_directory_allocation(PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+    // allocate page directory for the kernel, its page tables are shared with every task
+    KERNEL_PAGE_DIRECTORY_ = paging_kernel_directory_init();
+
+    // Large kernel buffers are mapped into the shared vmalloc window
+    vmalloc_init(KERNEL_PAGE_DIRECTORY_);
 
     // Switch to kernel paging chunk
     set_current_page_directory(KERNEL_PAGE_DIRECTORY_);
@@ -166,8 +178,6 @@ void kernel_main()
     // Initialize all the system keyboards
     keyboard_init();
 
-    probe_8gb_memory_count();
-
     struct Process* process = 0;
     int res = process_load_switch("0:/shell.elf", &process);
     if (res != ALL_OK)
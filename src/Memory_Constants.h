@@ -1,40 +1,61 @@
 #ifndef MEMORY_CONSTANTS_H
 #define MEMORY_CONSTANTS_H
 
+//****************************************** Physical Memory ******************************************
+
+/*
+0x00000000 - 0x00FFFFFF : BIOS areas, kernel image (1MB), kernel stack. Never handed out.
+
+PMM Base Address (0x01000000) :         ........
+                                        . PMM  . Frame bitmap, 1 bit per 4KB frame (96KB for 3GB)
+                                        ........
+                                        . Refs . Frame reference counts, 1 byte per 4KB frame (768KB for 3GB)
+                                        ........
+                                        . Heap . Kernel heap map, then the kernel heap itself
+                                        . ...  .
+                                        ........
+                                        . Free . Frames for later users (process memory, page tables ...)
+                                        ........
+Probed end of RAM, at most PMM_MAX_MEMORY_END
+*/
+
+// Free to use RAM : https://wiki.osdev.org/Memory_Map_(x86)
+#define PMM_BASE_ADDRESS 0x01000000 // 16MB offset
+
+// Probing stops below the PCI/APIC hole, 3GB of RAM at most.
+#define PMM_MAX_MEMORY_END 0xC0000000
+
+#define PMM_FRAME_SIZE 4096
+
+//****************************************** Physical Memory ******************************************
+
+
 //****************************************** Heap Map ******************************************
 
 /*
-Heap Map Base Address (0x00007E00) :  .......
+Heap Map Base Address (PMM frames) :    .......
                                         .  1  .  Entry 1 (8 bits)
                                         .......
                                         .  1  .  Entry 2 (8 bits)
                                         .......
 
 
-Heap Base Address (0x01000000)  :       ........
+Heap Base Address (PMM frames)  :       ........
                                         . 4096 . Block 1 base address
                                         ........
                                         . 4096 . Block 2 base address
                                         ........
                                         . 4096 . Block 3 base address
                                         ........
-*/
-
-//  480.5 KiB avaiable : https://wiki.osdev.org/Memory_Map_(x86)
-#define HEAP_MAP_BASE_ADDRESS 0x00007E00 // 31.5 KB offset
 
-// Free to use RAM : https://wiki.osdev.org/Memory_Map_(x86)
-#define HEAP_BASE_ADDRESS 0x01000000 // 16MB offset
-
-// 1024 bytes * 1024 = 1048576 (1MB), => 1048576 * 100 = 104857600 (100 MB)
-// 100MB available!
-#define TOTAL_HEAP_SIZE 104857600
+Both are reserved from the physical memory manager at boot, the heap gets KERNEL_HEAP_RAM_PERCENT of the free frames.
+*/
 
 // Heap block is 4KB (4096 bytes). For example: malloc(5000), => 8192 bytes allocated (2 blocks, 8KB)
 #define HEAP_BLOCK_SIZE 4096
 
-// Total 25600 blocks (104857600/4096)
-#define TOTAL_HEAP_MAP_BLOCKS TOTAL_HEAP_SIZE / HEAP_BLOCK_SIZE;
+// Smallest kernel heap, used when KERNEL_HEAP_RAM_PERCENT of the free RAM is less. 100MB.
+#define KERNEL_HEAP_MIN_SIZE 104857600
 
 //****************************************** Heap Map ******************************************
 
@@ -74,6 +95,12 @@ Each page table can map 1024 * (4096 bytes) = 4MB
 #define PAGE_SIZE 4096 ///< Size of page (4KB).
 #define TOTAL_PAGES_PER_TABLE 1024 ///< Number of pages per page table.
 
+// Kernel only vmalloc window, scattered PMM frames are mapped here into virtually contiguous ranges. Its page tables
+// are shared by every page directory, see paging_kernel_directory_init.
+#define VMALLOC_VIRTUAL_ADDRESS_BASE 0xC0000000
+
+#define VMALLOC_MAX_SIZE 0x10000000 // 256 MB
+
 //****************************************** Paging ******************************************
 
 
@@ -103,6 +130,17 @@ After ELF allocated into memory, kernel must map virtual regions to physical reg
 // 0x3FB000
 #define USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE (USER_PROCESS_STACK_VIRTUAL_ADDRESS_END - USER_PROCESS_STACK_SIZE)
 
+// User heap window, grown page by page with sbrk and backed by PMM frames. Above PMM_MAX_MEMORY_END so it never
+// shadows identity mapped RAM.
+#define USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE 0xD0000000
+
+#define USER_PROCESS_HEAP_MAX_SIZE 0x10000000 // 256 MB
+
+// Mapping window, shared memory segments and mapped files are placed here first fit. Right after the heap window.
+#define USER_PROCESS_MAP_VIRTUAL_ADDRESS_BASE 0xE0000000
+
+#define USER_PROCESS_MAP_MAX_SIZE 0x10000000 // 256 MB
+
 //****************************************** Pre-Defined User Process Virtual Addresses ******************************************
 
 
@@ -11,5 +11,6 @@
 #define EUNIMP 7
 #define EISTKN 8
 #define EINFORMAT 9
+#define EFAULT 10
 
 #endif
\ No newline at end of file
@@ -4,12 +4,14 @@ extern int21h_handler
 extern no_interrupt_handler
 extern isr80h_handler
 extern interrupt_handler
+extern idt_page_fault_handler
 
 global idt_load
 global no_interrupt
 global enable_interrupts
 global disable_interrupts
 global isr80h_wrapper
+global page_fault_wrapper
 global interrupt_pointer_table
 
 enable_interrupts:
@@ -91,9 +93,26 @@ isr80h_wrapper:
     mov eax, [tmp_res]
     iretd
 
+page_fault_wrapper:
+    ; The CPU pushes an error code on top of the interrupt frame for #PF,
+    ; pop it so the frame matches the other interrupts
+    pop dword[page_fault_error]
+    pushad
+
+    ; Push the stack pointer so that we are pointing to the interrupt frame
+    push esp
+    push dword[page_fault_error]
+    call idt_page_fault_handler
+    add esp, 8
+
+    popad
+    iretd
+
 section .data
 ; Inside here is stored the return result from isr80h_handler
 tmp_res: dd 0
+; Error code of the page fault being handled
+page_fault_error: dd 0
 
 
 %macro interrupt_array_entry 1
@@ -4,6 +4,9 @@ section .asm
 
 global paging_load_directory  
 global enable_paging          
+global paging_invalidate_page
+global paging_flush_all
+global paging_fault_address
 
 ; paging_load_directory: Loads the address of the page directory into the CR3 register.
 ; This is a necessary step for enabling paging, as CR3 holds the page directory base register (PDBR).
@@ -18,11 +21,50 @@ paging_load_directory:
 
 ; enable_paging: Sets the paging bit (bit 31) in the CR0 register to 1, which enables paging.
 ; CR0 is a control register that controls system behavior. Bit 31 is the PG flag (paging).
+; CR4 bit 4 (PSE) is set first, directory entries with the page size bit then map 4MB pages directly.
+; CR0 bit 16 (WP) makes the kernel fault on read only user pages too, copy-on-write pages get copied for it as well.
 enable_paging:
     push ebp                ; Save the old base pointer value on the stack
     mov ebp, esp            ; Create a new stack frame
+    mov eax, cr4            ; Move the current value of CR4 register into EAX
+    or eax, 0x00000010      ; Set bit 4 of EAX to 1 (page size extension)
+    mov cr4, eax            ; Update CR4, 4MB pages are allowed
     mov eax, cr0            ; Move the current value of CR0 register into EAX
-    or eax, 0x80000000      ; Set bit 31 of EAX to 1 (enables paging)
+    or eax, 0x80010000      ; Set bit 31 of EAX to 1 (enables paging) and bit 16 (write protect)
     mov cr0, eax            ; Update CR0 with the new value, effectively enabling paging
+    mov eax, cr4            ; Move the current value of CR4 register into EAX
+    or eax, 0x00000080      ; Set bit 7 of EAX to 1 (page global enable)
+    mov cr4, eax            ; Update CR4, global pages survive CR3 reloads
     pop ebp                 ; Restore the old base pointer value
-    ret                     ; Return to the caller, paging is now enabled
\ No newline at end of file
+    ret                     ; Return to the caller, paging is now enabled
+
+
+; paging_invalidate_page: Drops the TLB entry of the page that contains the given virtual address.
+; Needed after changing a mapping of the loaded page directory, the CPU would keep using the cached translation.
+paging_invalidate_page:
+    push ebp                ; Save the old base pointer value on the stack
+    mov ebp, esp            ; Create a new stack frame
+    mov eax, [ebp+8]        ; Move the first argument (virtual address) into EAX
+    invlpg [eax]            ; Invalidate the TLB entry for that address
+    pop ebp                 ; Restore the old base pointer value
+    ret                     ; Return to the caller
+
+
+; paging_flush_all: Drops every TLB entry, global ones included.
+; Reloading CR3 keeps global pages, clearing and setting CR4 bit 7 (PGE) flushes them as well.
+paging_flush_all:
+    push ebp                ; Save the old base pointer value on the stack
+    mov ebp, esp            ; Create a new stack frame
+    mov eax, cr4            ; Move the current value of CR4 register into EAX
+    and eax, 0xFFFFFF7F     ; Clear bit 7 (PGE)
+    mov cr4, eax            ; Flushes the whole TLB
+    or eax, 0x00000080      ; Set bit 7 (PGE) again
+    mov cr4, eax            ; Global pages are back on
+    pop ebp                 ; Restore the old base pointer value
+    ret                     ; Return to the caller
+
+
+; paging_fault_address: Returns CR2, the linear address that raised the last page fault.
+paging_fault_address:
+    mov eax, cr2            ; CR2 is only written by the CPU on #PF
+    ret                     ; Return the address in EAX
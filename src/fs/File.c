@@ -5,6 +5,7 @@
 #include "disk/Disk.h"
 #include "fat/Fat16.h"
 #include "memory/Memory.h"
+#include "malloc/Arena.h"
 #include "malloc/Kheap.h"
 #include "vga/Vga.h"
 
@@ -131,7 +132,9 @@ file_mode_t file_get_mode_by_string(const char* str)
 int fopen(const char* filename, const char* mode_str)
 {
     int res = 0;
-    struct PathRoot* root_path = pathparser_parse(filename, NULL);
+    struct Arena* scratch = arena_scratch();
+    size_t scratch_mark = arena_begin(scratch);
+    struct PathRoot* root_path = pathparser_parse(scratch, filename, NULL);
     if (!root_path)
     {
         res = -EINVARG;
@@ -185,6 +188,8 @@ int fopen(const char* filename, const char* mode_str)
     res = desc->index;
 
 out:
+    arena_reset(scratch, scratch_mark);
+
     // fopen shouldnt return negative values
     if (res < 0) res = 0;
 
@@ -201,6 +206,8 @@ int fstat(int fd, struct FileStat* stat)
         goto out;
     }
 
+    memset(stat, 0, sizeof(struct FileStat));
+    stat->diskId = desc->disk->diskId;
     res = desc->filesystem->stat(desc->disk, desc->private, stat);
 out:
     return res;
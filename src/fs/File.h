@@ -76,6 +76,8 @@ typedef int (*FS_SEEK_FUNCTION)(void *private, uint32_t offset, file_seek_mode_t
 struct FileStat {
     file_stat_flags_t flags; ///< Flags representing file status.
     uint32_t filesize;       ///< Size of the file.
+    int diskId;              ///< Disk the file is on.
+    uint32_t fileId;         ///< Stays the same for the file on its disk however the path is spelled, 0 when unknown.
 };
 
 /**
@@ -0,0 +1,195 @@
+#include "PageCache.h"
+#include "File.h"
+#include "Status.h"
+#include "malloc/Kheap.h"
+#include "memory/Memory.h"
+#include "paging/Paging.h"
+#include "pmm/Pmm.h"
+#include "vga/Vga.h"
+
+static struct PageCacheFile PAGE_CACHE_FILES_[MAX_PAGE_CACHE_FILES] = {};
+
+static void page_cache_free(struct PageCacheFile* file)
+{
+    for (uint32_t i = 0; i < file->totalPages; i++)
+    {
+        if (file->frames[i])
+        {
+            pmm_free_frame(file->frames[i]);
+        }
+    }
+
+    kernel_free_alloc(file->frames);
+    fclose(file->fd);
+    memset(file, 0, sizeof(struct PageCacheFile));
+}
+
+int page_cache_open(const char* path)
+{
+    // The file has to be opened to know which one it is, a cached one keeps its own descriptor.
+    int res = 0;
+    int fd = fopen(path, "r");
+    if (!fd)
+    {
+        return -EIO;
+    }
+
+    struct FileStat stat;
+    res = fstat(fd, &stat);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct PageCacheFile* free_slot = 0;
+    for (int i = 0; i < MAX_PAGE_CACHE_FILES; i++)
+    {
+        struct PageCacheFile* file = &PAGE_CACHE_FILES_[i];
+        if (file->fd && stat.fileId && file->diskId == stat.diskId && file->fileId == stat.fileId)
+        {
+            file->mappings++;
+            res = i;
+            fclose(fd);
+            goto out;
+        }
+
+        if (!file->fd && !free_slot)
+        {
+            free_slot = file;
+        }
+    }
+
+    if (!free_slot)
+    {
+        log("Error: page_cache_open no free file");
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Empty files have nothing to map.
+    uint32_t total_pages = (stat.filesize + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (total_pages == 0)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    void** frames = kernel_zeroed_alloc(total_pages * sizeof(void*));
+    if (!frames)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    free_slot->fd = fd;
+    free_slot->diskId = stat.diskId;
+    free_slot->fileId = stat.fileId;
+    free_slot->size = stat.filesize;
+    free_slot->totalPages = total_pages;
+    free_slot->frames = frames;
+    free_slot->mappings = 1;
+    res = free_slot - PAGE_CACHE_FILES_;
+
+out:
+    if (res < 0)
+    {
+        fclose(fd);
+    }
+    return res;
+}
+
+struct PageCacheFile* page_cache_get(int id)
+{
+    if (id < 0 || id >= MAX_PAGE_CACHE_FILES || !PAGE_CACHE_FILES_[id].fd)
+    {
+        return 0;
+    }
+
+    return &PAGE_CACHE_FILES_[id];
+}
+
+// Reads page index into a new zeroed frame, the part past the end of the file stays zero.
+static int page_cache_read_page(struct PageCacheFile* file, uint32_t index)
+{
+    void* frame = pmm_alloc_frame();
+    if (!frame)
+    {
+        return -ENOMEM;
+    }
+
+    memset(frame, 0x00, PAGE_SIZE);
+    uint32_t offset = index * PAGE_SIZE;
+    uint32_t total = file->size - offset < PAGE_SIZE ? file->size - offset : PAGE_SIZE;
+
+    int res = fseek(file->fd, offset, SEEK_SET);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    if (fread(frame, total, 1, file->fd) != 1)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    file->frames[index] = frame;
+
+out:
+    if (res < 0)
+    {
+        pmm_free_frame(frame);
+    }
+    return res;
+}
+
+int page_cache_map_page(int id, uint32_t index, void** frame)
+{
+    struct PageCacheFile* file = page_cache_get(id);
+    if (!file || index >= file->totalPages)
+    {
+        return -EINVARG;
+    }
+
+    if (!file->frames[index])
+    {
+        int res = page_cache_read_page(file, index);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    int res = pmm_frame_ref(file->frames[index]);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    *frame = file->frames[index];
+    return 0;
+}
+
+void page_cache_ref(int id)
+{
+    struct PageCacheFile* file = page_cache_get(id);
+    if (file)
+    {
+        file->mappings++;
+    }
+}
+
+void page_cache_put(int id)
+{
+    struct PageCacheFile* file = page_cache_get(id);
+    if (!file)
+    {
+        return;
+    }
+
+    file->mappings--;
+    if (file->mappings <= 0)
+    {
+        page_cache_free(file);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <stdint.h>
+#include "Config.h"
+
+/*
+Page cache for mapped files : the pages of a file read in from its filesystem one at a time, on first access.
+
+Every process that maps the same file shares the cached frames, files are told apart by their disk and the id fstat
+gives them rather than by path. The cache holds one reference per frame, each
+mapped page one more (PAGING_IS_OWNED). A file keeps its descriptor open while it has mappings and leaves the
+cache with the last one.
+*/
+
+struct PageCacheFile {
+    int fd;                   ///< Open descriptor the pages are read from, 0 when the slot is unused.
+    int diskId;               ///< Disk of the file.
+    uint32_t fileId;          ///< Id of the file on its disk, from fstat.
+    uint32_t size;            ///< File size in bytes.
+    uint32_t totalPages;      ///< Pages covering size.
+    void **frames;            ///< Frame of each page, 0 until it is read in.
+    int mappings;             ///< Process regions that map the file, forks included.
+};
+
+// Opens path into the cache, or finds it there, and counts one more mapping. The file id or -EIO, -ENOMEM.
+extern int page_cache_open(const char *path);
+
+extern struct PageCacheFile *page_cache_get(int id);
+
+// Frame of page index, read in on first use, with one more reference for the caller's mapping.
+// -EINVARG past the end of the file, -EIO, -ENOMEM.
+extern int page_cache_map_page(int id, uint32_t index, void **frame);
+
+// Counts one more mapping of an open file.
+extern void page_cache_ref(int id);
+
+// Drops one mapping, the file's frames and descriptor go with the last one.
+extern void page_cache_put(int id);
+
+#endif
@@ -2,7 +2,7 @@
 #include "PathParser.h"
 #include "Status.h"
 #include "memory/Memory.h"
-#include "malloc/Kheap.h"
+#include "malloc/Arena.h"
 
 static int pathparser_path_valid_format(const char* filename)
 {
@@ -24,49 +24,64 @@ static int pathparser_get_drive_by_path(const char** path)
     return drive_no;
 }
 
-static struct PathRoot* pathparser_create_root(int drive_number)
+static struct PathRoot* pathparser_create_root(struct Arena* arena, int drive_number)
 {
-    struct PathRoot* path_r = kernel_zeroed_alloc(sizeof(struct PathRoot));
+    struct PathRoot* path_r = arena_alloc(arena, sizeof(struct PathRoot));
+    if (!path_r)
+    {
+        return 0;
+    }
+
     path_r->driveNo = drive_number;
     path_r->first = 0;
     return path_r;
 }
 
-static const char* pathparser_get_path_part(const char** path)
+static const char* pathparser_get_path_part(struct Arena* arena, const char** path)
 {
-    char* result_path_part = kernel_zeroed_alloc(PEACHOS_MAX_PATH);
-    int i = 0;
-    while (**path != '/' && **path != 0x00)
+    int len = 0;
+    while ((*path)[len] != '/' && (*path)[len] != 0x00)
     {
-        result_path_part[i] = **path;
-        *path += 1;
-        i++;
+        len++;
     }
 
-    if (**path == '/')
+    if (len == 0)
     {
-        // Skip the forward slash to avoid problems
-        *path += 1;
+        return 0;
     }
 
-    if (i == 0)
+    char* result_path_part = arena_alloc(arena, len + 1);
+    if (!result_path_part)
+    {
+        return 0;
+    }
+
+    memcpy(result_path_part, (void*)*path, len);
+    *path += len;
+
+    if (**path == '/')
     {
-        kernel_free_alloc(result_path_part);
-        result_path_part = 0;
+        // Skip the forward slash to avoid problems
+        *path += 1;
     }
 
     return result_path_part;
 }
 
-struct PathPart* pathparser_parse_path_part(struct PathPart* last_part, const char** path)
+struct PathPart* pathparser_parse_path_part(struct Arena* arena, struct PathPart* last_part, const char** path)
 {
-    const char* path_part_str = pathparser_get_path_part(path);
+    const char* path_part_str = pathparser_get_path_part(arena, path);
     if (!path_part_str)
     {
         return 0;
     }
 
-    struct PathPart* part = kernel_zeroed_alloc(sizeof(struct PathPart));
+    struct PathPart* part = arena_alloc(arena, sizeof(struct PathPart));
+    if (!part)
+    {
+        return 0;
+    }
+
     part->part = path_part_str;
     part->next = 0x00;
 
@@ -78,21 +93,7 @@ struct PathPart* pathparser_parse_path_part(struct PathPart* last_part, const ch
     return part;
 }
 
-void pathparser_free(struct PathRoot* root)
-{
-    struct PathPart* part = root->first;
-    while (part)
-    {
-        struct PathPart* next_part = part->next;
-        kernel_free_alloc((void*)part->part);
-        kernel_free_alloc(part);
-        part = next_part;
-    }
-
-    kernel_free_alloc(root);
-}
-
-struct PathRoot* pathparser_parse(const char* path, const char* current_directory_path)
+struct PathRoot* pathparser_parse(struct Arena* arena, const char* path, const char* current_directory_path)
 {
     int res = 0;
     const char* tmp_path = path;
@@ -109,23 +110,23 @@ struct PathRoot* pathparser_parse(const char* path, const char* current_director
         goto out;
     }
 
-    path_root = pathparser_create_root(res);
+    path_root = pathparser_create_root(arena, res);
     if (!path_root)
     {
         goto out;
     }
 
-    struct PathPart* first_part = pathparser_parse_path_part(NULL, &tmp_path);
+    struct PathPart* first_part = pathparser_parse_path_part(arena, NULL, &tmp_path);
     if (!first_part)
     {
         goto out;
     }
 
     path_root->first = first_part;
-    struct PathPart* part = pathparser_parse_path_part(first_part, &tmp_path);
+    struct PathPart* part = pathparser_parse_path_part(arena, first_part, &tmp_path);
     while (part)
     {
-        part = pathparser_parse_path_part(part, &tmp_path);
+        part = pathparser_parse_path_part(arena, part, &tmp_path);
     }
 
 out:
@@ -11,8 +11,9 @@ struct PathPart {
     struct PathPart *next;
 };
 
-extern struct PathRoot *pathparser_parse(const char *path, const char *current_directory_path);
+struct Arena;
 
-extern void pathparser_free(struct PathRoot *root);
+// The whole path lives in arena, it's released with the arena scope rather than freed.
+extern struct PathRoot *pathparser_parse(struct Arena *arena, const char *path, const char *current_directory_path);
 
 #endif
\ No newline at end of file
@@ -4,7 +4,9 @@
 #include "disk/Disk.h"
 #include "disk/Streamer.h"
 #include "memory/Memory.h"
+#include "malloc/Arena.h"
 #include "malloc/Kheap.h"
+#include "malloc/Vmalloc.h"
 #include <stdint.h>
 
 #define FAT16_SIGNATURE 0x29
@@ -503,7 +505,11 @@ void fat16_free_directory(struct fat_directory* directory)
         return;
     }
 
-    if (directory->item)
+    if (is_vmalloc_address(directory->item))
+    {
+        vfree(directory->item);
+    }
+    else if (directory->item)
     {
         kernel_free_alloc(directory->item);
     }
@@ -525,22 +531,15 @@ void fat16_fat_item_free(struct fat_item* item)
     kernel_free_alloc(item);
 }
 
-struct fat_directory* fat16_load_fat_directory(struct Disk* disk, struct fat_directory_item* item)
+// Reads the entries of a subdirectory, from arena when given, kernel heap otherwise. Directories of a page or more
+// go to vmalloc so they don't need a contiguous heap run.
+static int fat16_read_directory(struct Disk* disk, struct fat_directory_item* item, struct fat_directory* directory,
+                                struct Arena* arena)
 {
-    int res = 0;
-    struct fat_directory* directory = 0;
     struct fat_private* fat_private = disk->fsPrivate;
     if (!(item->attribute & FAT_FILE_SUBDIRECTORY))
     {
-        res = -EINVARG;
-        goto out;
-    }
-
-    directory = kernel_zeroed_alloc(sizeof(struct fat_directory));
-    if (!directory)
-    {
-        res = -ENOMEM;
-        goto out;
+        return -EINVARG;
     }
 
     int cluster = fat16_get_first_cluster(item);
@@ -548,23 +547,40 @@ struct fat_directory* fat16_load_fat_directory(struct Disk* disk, struct fat_dir
     int total_items = fat16_get_total_items_for_directory(disk, cluster_sector);
     directory->total = total_items;
     int directory_size = directory->total * sizeof(struct fat_directory_item);
-    directory->item = kernel_zeroed_alloc(directory_size);
+    if (arena)
+    {
+        directory->item = arena_alloc(arena, directory_size);
+    }
+    else
+    {
+        directory->item = directory_size >= PAGE_SIZE ? vmalloc(directory_size) : kernel_zeroed_alloc(directory_size);
+    }
+
     if (!directory->item)
     {
-        res = -ENOMEM;
-        goto out;
+        return -ENOMEM;
     }
 
-    res = fat16_read_internal(disk, cluster, 0x00, directory_size, directory->item);
-    if (res != ALL_OK)
+    return fat16_read_internal(disk, cluster, 0x00, directory_size, directory->item);
+}
+
+struct fat_directory* fat16_load_fat_directory(struct Disk* disk, struct fat_directory_item* item)
+{
+    int res = 0;
+    struct fat_directory* directory = kernel_zeroed_alloc(sizeof(struct fat_directory));
+    if (!directory)
     {
+        res = -ENOMEM;
         goto out;
     }
 
+    res = fat16_read_directory(disk, item, directory, 0);
+
 out:
     if (res != ALL_OK)
     {
         fat16_free_directory(directory);
+        directory = 0;
     }
     return directory;
 }
@@ -589,49 +605,50 @@ struct fat_item* fat16_new_fat_item_for_directory_item(struct Disk* disk, struct
     return f_item;
 }
 
-struct fat_item* fat16_find_item_in_directory(struct Disk* disk, struct fat_directory* directory, const char* name)
+static struct fat_directory_item* fat16_find_directory_item(struct fat_directory* directory, const char* name)
 {
-    struct fat_item* f_item = 0;
     char tmp_filename[PEACHOS_MAX_PATH];
     for (int i = 0; i < directory->total; i++)
     {
         fat16_get_full_relative_filename(&directory->item[i], tmp_filename, sizeof(tmp_filename));
         if (istrncmp(tmp_filename, name, sizeof(tmp_filename)) == 0)
         {
-            // Found it let's create a new fat_item
-            f_item = fat16_new_fat_item_for_directory_item(disk, &directory->item[i]);
+            return &directory->item[i];
         }
     }
 
-    return f_item;
+    return 0;
 }
 
+// Intermediate directories are only walked, they're read into the scratch arena and dropped once the final
+// entry has been copied to the kernel heap.
 struct fat_item* fat16_get_directory_entry(struct Disk* disk, struct PathPart* path)
 {
     struct fat_private* fat_private = disk->fsPrivate;
     struct fat_item* current_item = 0;
-    struct fat_item* root_item = fat16_find_item_in_directory(disk, &fat_private->root_directory, path->part);
-    if (!root_item)
-    {
-        goto out;
-    }
+    struct Arena* scratch = arena_scratch();
+    size_t scratch_mark = arena_begin(scratch);
 
-    struct PathPart* next_part = path->next;
-    current_item = root_item;
-    while (next_part != 0)
+    struct fat_directory_item* item = fat16_find_directory_item(&fat_private->root_directory, path->part);
+    while (item && path->next)
     {
-        if (current_item->type != FAT_ITEM_TYPE_DIRECTORY)
+        struct fat_directory* directory = arena_alloc(scratch, sizeof(struct fat_directory));
+        if (!directory || fat16_read_directory(disk, item, directory, scratch) != ALL_OK)
         {
-            current_item = 0;
+            item = 0;
             break;
         }
 
-        struct fat_item* tmp_item = fat16_find_item_in_directory(disk, current_item->directory, next_part->part);
-        fat16_fat_item_free(current_item);
-        current_item = tmp_item;
-        next_part = next_part->next;
+        path = path->next;
+        item = fat16_find_directory_item(directory, path->part);
     }
-out:
+
+    if (item)
+    {
+        current_item = fat16_new_fat_item_for_directory_item(disk, item);
+    }
+
+    arena_reset(scratch, scratch_mark);
     return current_item;
 }
 
@@ -694,6 +711,8 @@ int fat16_stat(struct Disk* disk, void* private, struct FileStat* stat)
     struct fat_directory_item* ritem = desc_item->item;
     stat->filesize = ritem->filesize;
     stat->flags = 0x00;
+    // Paths are case insensitive, the first cluster isn't.
+    stat->fileId = fat16_get_first_cluster(ritem);
 
     if (ritem->attribute & FAT_FILE_READ_ONLY)
     {
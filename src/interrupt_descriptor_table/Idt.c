@@ -4,6 +4,7 @@
 #include "Status.h"
 #include "io/Io.h"
 #include "memory/Memory.h"
+#include "paging/Paging.h"
 #include "process/Process.h"
 #include "process/Task.h"
 #include "vga/Vga.h"
@@ -25,6 +26,8 @@ extern void no_interrupt();
 
 extern void isr80h_wrapper();
 
+extern void page_fault_wrapper();
+
 void no_interrupt_handler()
 {
     outb(0x20, 0x20);
@@ -36,14 +39,40 @@ void idt_zero_callback()
 }
 
 
-void idt_page_fault_callback()
+// Demand paging: not present pages of the current process's regions get a frame, written copy-on-write pages a
+// private copy, and the access is retried. Any other fault ends the process, or the kernel when the kernel faulted.
+void idt_page_fault_handler(uint32_t error_code, struct InterruptFrame* frame)
 {
+    kernel_registers();
+
+    void* address = paging_fault_address();
+    struct Task* task = task_current();
+    if (task && process_handle_page_fault(task->process, address, error_code) == 0)
+    {
+        // Back to the user segments only when user code faulted, a syscall touching user memory carries on.
+        if (error_code & PAGING_FAULT_USER)
+        {
+            user_registers();
+        }
+        return;
+    }
+
+    if (task && (error_code & PAGING_FAULT_USER))
+    {
+        logAddress("Page fault at: ", (unsigned long)address);
+        process_terminate(task->process);
+        run_next_task();
+    }
+
+    logAddress("Page fault at: ", (unsigned long)address);
     panic("Page fault error!\n");
 }
 
+// Kernel memory is mapped in every page directory, interrupts run on the interrupted task's directory and only
+// switch segment registers. CR3 changes on a task switch alone.
 void interrupt_handler(int interrupt, struct InterruptFrame* frame)
 {
-    kernel_page(); // switch to kernel pages
+    kernel_registers();
 
     if (interrupt_callbacks[interrupt] != 0)
     {
@@ -51,7 +80,7 @@ void interrupt_handler(int interrupt, struct InterruptFrame* frame)
         interrupt_callbacks[interrupt](frame);
     }
 
-    task_page(); // switch to process pages
+    user_registers();
     outb(0x20, 0x20);
 }
 
@@ -122,7 +151,7 @@ void idt_init()
     // https://wiki.osdev.org/Exceptions
     idt_set(0, idt_zero_callback);
     idt_set(0x80, isr80h_wrapper); // set interrupt service routines
-    idt_set(0xE, idt_page_fault_callback);
+    idt_set(0xE, page_fault_wrapper);
 
     for (int i = 0; i < 0x20; i++)
     {
@@ -187,9 +216,9 @@ void* isr80h_handle_command(int command, struct InterruptFrame* frame)
 void* isr80h_handler(int command, struct InterruptFrame* frame)
 {
     void* res = 0;
-    kernel_page();
+    kernel_registers();
     task_current_save_state(frame);
     res = isr80h_handle_command(command, frame);
-    task_page();
+    user_registers();
     return res;
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "Heap_isr.h"
+#include "Config.h"
+#include "Kernel.h"
+#include "Status.h"
+#include "malloc/Kheap.h"
+#include "memory/Memory.h"
 #include "process/Process.h"
+#include "process/Shm.h"
 #include "process/Task.h"
 #include <stddef.h>
 
@@ -17,4 +23,88 @@ void* isr80h_command5_free(struct InterruptFrame* frame)
     process_free(task_current()->process, ptr_to_free);
     
     return 0;
-}
\ No newline at end of file
+}
+
+void* isr80h_command12_realloc(struct InterruptFrame* frame)
+{
+    void* ptr = task_get_stack_item(task_current(), 0);
+    size_t size = (int)task_get_stack_item(task_current(), 1);
+
+    return process_realloc(task_current()->process, ptr, size);
+}
+
+void* isr80h_command10_heap_stats(struct InterruptFrame* frame)
+{
+    void* user_stats = task_get_stack_item(task_current(), 0);
+
+    struct KernelHeapStats stats;
+    kernel_heap_get_stats(&stats);
+    int res = copy_to_user(task_current(), user_stats, &stats, sizeof(stats));
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
+
+    return 0;
+}
+
+void* isr80h_command11_sbrk(struct InterruptFrame* frame)
+{
+    int increment = (int)task_get_stack_item(task_current(), 0);
+
+    return process_sbrk(task_current()->process, increment);
+}
+
+void* isr80h_command14_shm_create(struct InterruptFrame* frame)
+{
+    size_t size = (int)task_get_stack_item(task_current(), 0);
+
+    return ERROR(shm_create(size, task_current()->process->processId));
+}
+
+void* isr80h_command15_shm_map(struct InterruptFrame* frame)
+{
+    int segment = (int)task_get_stack_item(task_current(), 0);
+
+    // The window is above 2GB, errors can't be told from addresses by sign, 0 it is.
+    void* address = 0;
+    if (process_shm_map(task_current()->process, segment, &address) < 0)
+    {
+        return 0;
+    }
+
+    return address;
+}
+
+void* isr80h_command16_shm_unmap(struct InterruptFrame* frame)
+{
+    void* address = task_get_stack_item(task_current(), 0);
+
+    return ERROR(process_shm_unmap(task_current()->process, address));
+}
+
+void* isr80h_command17_mmap(struct InterruptFrame* frame)
+{
+    void* path_user_ptr = task_get_stack_item(task_current(), 0);
+    char path[MAX_PATH_SIZE];
+    if (strncpy_from_user(task_current(), path, path_user_ptr, sizeof(path)) < 0)
+    {
+        return 0;
+    }
+
+    // Addresses are above 2GB like shm_map, 0 on failure.
+    void* address = 0;
+    if (process_mmap(task_current()->process, path, &address) < 0)
+    {
+        return 0;
+    }
+
+    return address;
+}
+
+void* isr80h_command18_munmap(struct InterruptFrame* frame)
+{
+    void* address = task_get_stack_item(task_current(), 0);
+
+    return ERROR(process_munmap(task_current()->process, address));
+}
@@ -8,4 +8,20 @@ extern void *isr80h_command4_malloc(struct InterruptFrame *frame);
 
 extern void *isr80h_command5_free(struct InterruptFrame *frame);
 
+extern void *isr80h_command12_realloc(struct InterruptFrame *frame);
+
+extern void *isr80h_command10_heap_stats(struct InterruptFrame *frame);
+
+extern void *isr80h_command11_sbrk(struct InterruptFrame *frame);
+
+extern void *isr80h_command14_shm_create(struct InterruptFrame *frame);
+
+extern void *isr80h_command15_shm_map(struct InterruptFrame *frame);
+
+extern void *isr80h_command16_shm_unmap(struct InterruptFrame *frame);
+
+extern void *isr80h_command17_mmap(struct InterruptFrame *frame);
+
+extern void *isr80h_command18_munmap(struct InterruptFrame *frame);
+
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "Io_isr.h"
+#include "Config.h"
+#include "Kernel.h"
 #include "keyboard/Keyboard.h"
+#include "malloc/Kheap.h"
 #include "process/Task.h"
 #include "vga/Vga.h"
 
@@ -7,7 +10,11 @@ void* isr80h_command1_print(struct InterruptFrame* frame)
 {
     void* user_space_msg_buffer = task_get_stack_item(task_current(), 0);
     char buf[1024];
-    copy_string_from_task(task_current(), user_space_msg_buffer, buf, sizeof(buf));
+    int res = strncpy_from_user(task_current(), buf, user_space_msg_buffer, sizeof(buf));
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
 
     print(buf);
     return 0;
@@ -16,6 +23,11 @@ void* isr80h_command1_print(struct InterruptFrame* frame)
 void* isr80h_command2_getkey(struct InterruptFrame* frame)
 {
     char c = keyboard_pop();
+    if (!c)
+    {
+        // The caller is polling for input, use the wait to prepare zeroed blocks.
+        kernel_zero_pool_refill(KERNEL_ZERO_POOL_IDLE_REFILL);
+    }
     return (void*)((int)c);
 }
 
@@ -10,7 +10,7 @@ void* isr80h_command6_process_load_start(struct InterruptFrame* frame)
 {
     void* filename_user_ptr = task_get_stack_item(task_current(), 0);
     char filename[MAX_PATH_SIZE];
-    int res = copy_string_from_task(task_current(), filename_user_ptr, filename, sizeof(filename));
+    int res = strncpy_from_user(task_current(), filename, filename_user_ptr, sizeof(filename));
     if (res < 0)
     {
         goto out;
@@ -34,48 +34,97 @@ out:
     return 0;
 }
 
+// Copies the caller's argument list into the scratch arena, the next pointers are user addresses.
+static int isr80h_copy_command_arguments(struct Task* task, struct Arena* scratch, void* user_argument,
+                                         struct CommandArgument** root_argument)
+{
+    struct CommandArgument** link = root_argument;
+    while (user_argument)
+    {
+        struct CommandArgument* argument = arena_alloc(scratch, sizeof(struct CommandArgument));
+        if (!argument)
+        {
+            return -ENOMEM;
+        }
+
+        int res = copy_from_user(task, argument, user_argument, sizeof(struct CommandArgument));
+        if (res < 0)
+        {
+            return res;
+        }
+
+        argument->argument[sizeof(argument->argument) - 1] = 0;
+        user_argument = argument->next;
+        argument->next = 0;
+        *link = argument;
+        link = &argument->next;
+    }
+
+    return 0;
+}
+
 void* isr80h_command7_invoke_system_command(struct InterruptFrame* frame)
 {
-    struct CommandArgument* arguments =
-        task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
-    if (!arguments || strlen(arguments[0].argument) == 0)
+    struct Arena* scratch = arena_scratch();
+    size_t scratch_mark = arena_begin(scratch);
+
+    struct CommandArgument* root_command_argument = 0;
+    int res = isr80h_copy_command_arguments(task_current(), scratch, task_get_stack_item(task_current(), 0),
+                                            &root_command_argument);
+    if (res < 0)
     {
-        return ERROR(-EINVARG);
+        goto out;
+    }
+
+    if (!root_command_argument || strlen(root_command_argument->argument) == 0)
+    {
+        res = -EINVARG;
+        goto out;
     }
 
-    struct CommandArgument* root_command_argument = &arguments[0];
     const char* program_name = root_command_argument->argument;
 
     char path[MAX_PATH_SIZE];
     strcpy(path, "0:/");
-    strncpy(path + 3, program_name, sizeof(path));
+    strncpy(path + 3, program_name, sizeof(path) - 3);
+    path[sizeof(path) - 1] = 0;
 
     struct Process* process = 0;
-    int res = process_load_switch(path, &process);
+    res = process_load_switch(path, &process);
     if (res < 0)
     {
-        return ERROR(res);
+        goto out;
     }
 
     res = process_inject_arguments(process, root_command_argument);
     if (res < 0)
     {
-        return ERROR(res);
+        goto out;
     }
 
+    // task_return doesn't come back, the copies go first.
+    arena_reset(scratch, scratch_mark);
     set_current_task(process->task);
     task_return(&process->task->registers);
 
-    return 0;
+out:
+    arena_reset(scratch, scratch_mark);
+    return ERROR(res);
 }
 
 void* isr80h_command8_get_program_arguments(struct InterruptFrame* frame)
 {
     struct Process* process = task_current()->process;
-    struct ProcessArguments* arguments =
-        task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
+    void* user_arguments = task_get_stack_item(task_current(), 0);
+
+    struct ProcessArguments arguments;
+    process_get_arguments(process, &arguments.argc, &arguments.argv);
+    int res = copy_to_user(task_current(), user_arguments, &arguments, sizeof(arguments));
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
 
-    process_get_arguments(process, &arguments->argc, &arguments->argv);
     return 0;
 }
 
@@ -88,4 +137,16 @@ void* isr80h_command9_exit(struct InterruptFrame* frame)
     run_next_task();
     
     return 0;
-}
\ No newline at end of file
+}
+
+void* isr80h_command13_fork(struct InterruptFrame* frame)
+{
+    struct Process* child = 0;
+    int res = process_fork(task_current()->process, &child);
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
+
+    return (void*)(uint32_t)child->processId;
+}
@@ -59,4 +59,14 @@ extern void *isr80h_command8_get_program_arguments(struct InterruptFrame *frame)
  */
 extern void *isr80h_command9_exit(struct InterruptFrame *frame);
 
+/**
+ * @brief Forks the currently executing process.
+ *
+ * The child gets a copy-on-write view of the caller's address space and returns from the same system call with 0.
+ *
+ * @param frame Pointer to an interrupt frame structure, unused in this context but provided for consistency.
+ * @return The child's process id to the caller, or a negative error code.
+ */
+extern void *isr80h_command13_fork(struct InterruptFrame *frame);
+
 #endif // ISR80H_PROCESS_H
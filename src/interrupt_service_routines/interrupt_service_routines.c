@@ -35,4 +35,22 @@ void isr80h_register_commands()
     isr80h_register_command(SYSTEM_COMMAND8_GET_PROGRAM_ARGUMENTS, isr80h_command8_get_program_arguments); ///< Register handler for getting program arguments.
     
     isr80h_register_command(SYSTEM_COMMAND9_EXIT, isr80h_command9_exit); ///< Register handler for program exit.
+    
+    isr80h_register_command(SYSTEM_COMMAND10_HEAP_STATS, isr80h_command10_heap_stats); ///< Register handler for kernel heap statistics.
+    
+    isr80h_register_command(SYSTEM_COMMAND11_SBRK, isr80h_command11_sbrk); ///< Register handler for user heap growth.
+    
+    isr80h_register_command(SYSTEM_COMMAND12_REALLOC, isr80h_command12_realloc); ///< Register handler for resizing allocated memory.
+    
+    isr80h_register_command(SYSTEM_COMMAND13_FORK, isr80h_command13_fork); ///< Register handler for process fork.
+    
+    isr80h_register_command(SYSTEM_COMMAND14_SHM_CREATE, isr80h_command14_shm_create); ///< Register handler for shared memory creation.
+    
+    isr80h_register_command(SYSTEM_COMMAND15_SHM_MAP, isr80h_command15_shm_map); ///< Register handler for shared memory mapping.
+    
+    isr80h_register_command(SYSTEM_COMMAND16_SHM_UNMAP, isr80h_command16_shm_unmap); ///< Register handler for shared memory unmapping.
+    
+    isr80h_register_command(SYSTEM_COMMAND17_MMAP, isr80h_command17_mmap); ///< Register handler for file mapping.
+    
+    isr80h_register_command(SYSTEM_COMMAND18_MUNMAP, isr80h_command18_munmap); ///< Register handler for file unmapping.
 }
\ No newline at end of file
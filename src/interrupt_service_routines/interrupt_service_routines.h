@@ -29,7 +29,16 @@ enum SystemCommands
     SYSTEM_COMMAND6_PROCESS_LOAD_START = 6,     ///< Starts loading a process.
     SYSTEM_COMMAND7_INVOKE_SYSTEM_COMMAND = 7,  ///< Invokes another system command.
     SYSTEM_COMMAND8_GET_PROGRAM_ARGUMENTS = 8,  ///< Retrieves program arguments.
-    SYSTEM_COMMAND9_EXIT = 9                    ///< Exits the current program.
+    SYSTEM_COMMAND9_EXIT = 9,                   ///< Exits the current program.
+    SYSTEM_COMMAND10_HEAP_STATS = 10,           ///< Copies the kernel heap statistics out.
+    SYSTEM_COMMAND11_SBRK = 11,                 ///< Grows or shrinks the process's user heap.
+    SYSTEM_COMMAND12_REALLOC = 12,              ///< Resizes memory allocated with SYSTEM_COMMAND4_MALLOC.
+    SYSTEM_COMMAND13_FORK = 13,                 ///< Copies the current process, copy-on-write.
+    SYSTEM_COMMAND14_SHM_CREATE = 14,           ///< Creates a shared memory segment.
+    SYSTEM_COMMAND15_SHM_MAP = 15,              ///< Maps a shared memory segment into the process.
+    SYSTEM_COMMAND16_SHM_UNMAP = 16,            ///< Unmaps a shared memory segment.
+    SYSTEM_COMMAND17_MMAP = 17,                 ///< Maps a file read only through the page cache.
+    SYSTEM_COMMAND18_MUNMAP = 18                ///< Unmaps a file mapped with SYSTEM_COMMAND17_MMAP.
 };
 
 /**
@@ -53,7 +53,6 @@ uint8_t classic_keyboard_scancode_to_char(uint8_t scancode)
 
 void classic_keyboard_handle_interrupt()
 {
-    kernel_page();
     uint8_t scancode = 0;
     scancode = insb(KEYBOARD_INPUT_PORT);
     insb(KEYBOARD_INPUT_PORT);
@@ -75,8 +74,6 @@ void classic_keyboard_handle_interrupt()
     {
         keyboard_push(c);
     }
-
-    task_page();
 }
 
 struct Keyboard* classic_init()
@@ -3,7 +3,9 @@
 #include "Kernel.h"
 #include "Status.h"
 #include "fs/File.h"
+#include "malloc/Arena.h"
 #include "malloc/Kheap.h"
+#include "malloc/Vmalloc.h"
 #include "memory/Memory.h"
 #include "paging/Paging.h"
 #include "vga/Vga.h"
@@ -106,7 +108,7 @@ void elf_close(struct ElfFile* file)
 {
     if (!file) return;
 
-    kernel_free_alloc(file->elf_memory);
+    vfree(file->elf_memory);
     kernel_free_alloc(file);
 }
 
@@ -186,10 +188,86 @@ out:
     return res;
 }
 
+// Checks the ELF and program headers before the file image is allocated, the headers are read into the
+// scratch arena so a bad binary costs no kernel heap. The file part of every PT_LOAD segment must be in the file,
+// .bss past it is demand paged by the process.
+static int elf_validate_file(int fd, uint32_t filesize)
+{
+    int res = 0;
+    struct Arena* scratch = arena_scratch();
+    size_t scratch_mark = arena_begin(scratch);
+
+    struct ElfHeader* header = arena_alloc(scratch, sizeof(struct ElfHeader));
+    if (!header)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    if (filesize < sizeof(struct ElfHeader) || fread(header, sizeof(struct ElfHeader), 1, fd) < 0)
+    {
+        res = -EINFORMAT;
+        goto out;
+    }
+
+    res = elf_validate_loaded(header);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    uint32_t pheaders_size = header->e_phnum * sizeof(struct Elf32Phdr);
+    if (header->e_phoff > filesize || pheaders_size > filesize - header->e_phoff)
+    {
+        res = -EINFORMAT;
+        goto out;
+    }
+
+    struct Elf32Phdr* pheaders = arena_alloc(scratch, pheaders_size);
+    if (!pheaders)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = fseek(fd, header->e_phoff, SEEK_SET);
+    if (res < 0 || fread(pheaders, pheaders_size, 1, fd) < 0)
+    {
+        res = -EINFORMAT;
+        goto out;
+    }
+
+    for (int i = 0; i < header->e_phnum; i++)
+    {
+        if (pheaders[i].p_type != PT_LOAD)
+        {
+            continue;
+        }
+
+        if (pheaders[i].p_offset > filesize || pheaders[i].p_filesz > filesize - pheaders[i].p_offset ||
+            pheaders[i].p_filesz > pheaders[i].p_memsz)
+        {
+            res = -EINFORMAT;
+            goto out;
+        }
+    }
+
+    res = fseek(fd, 0, SEEK_SET);
+
+out:
+    arena_reset(scratch, scratch_mark);
+    return res;
+}
+
 int elf_load(const char* filename, struct ElfFile** file_out)
 {
     struct ElfFile* elf_file = kernel_zeroed_alloc(sizeof(struct ElfFile));
     int fd = 0;
+    if (!elf_file)
+    {
+        return -ENOMEM;
+    }
+
     int res = fopen(filename, "r");
     if (res <= 0)
     {
@@ -205,7 +283,19 @@ int elf_load(const char* filename, struct ElfFile** file_out)
         goto out;
     }
 
-    elf_file->elf_memory = kernel_zeroed_alloc(stat.filesize);
+    res = elf_validate_file(fd, stat.filesize);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // Mapped page by page into the process, doesn't need to be physically contiguous.
+    elf_file->elf_memory = vmalloc(stat.filesize);
+    if (!elf_file->elf_memory)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
 
     logAddress("elf_memory : ", (unsigned long)elf_file->elf_memory);
 
@@ -223,6 +313,14 @@ int elf_load(const char* filename, struct ElfFile** file_out)
 
     *file_out = elf_file;
 out:
-    fclose(fd);
+    if (res < 0)
+    {
+        elf_close(elf_file);
+    }
+
+    if (fd)
+    {
+        fclose(fd);
+    }
     return res;
-}
\ No newline at end of file
+}
@@ -0,0 +1,72 @@
+#include "Arena.h"
+#include "Config.h"
+#include "Kheap.h"
+#include "Status.h"
+#include "memory/Memory.h"
+#include "process/Task.h"
+#include "vga/Vga.h"
+
+// Scratch space for kernel code that runs without a current task, e.g. loading the first process.
+static struct Arena BOOT_ARENA_;
+
+int arena_init(struct Arena* arena, size_t size)
+{
+    memset(arena, 0, sizeof(struct Arena));
+
+    arena->base_ = kernel_page_alloc(size);
+    if (!arena->base_)
+    {
+        return -ENOMEM;
+    }
+
+    arena->size_ = size;
+    return 0;
+}
+
+void arena_release(struct Arena* arena)
+{
+    kernel_free_alloc(arena->base_);
+    memset(arena, 0, sizeof(struct Arena));
+}
+
+size_t arena_begin(struct Arena* arena)
+{
+    return arena->used_;
+}
+
+void* arena_alloc(struct Arena* arena, size_t size)
+{
+    size_t aligned_size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    if (aligned_size > arena->size_ - arena->used_)
+    {
+        log("Error: arena_alloc arena is full");
+        return 0;
+    }
+
+    void* ptr = arena->base_ + arena->used_;
+    arena->used_ += aligned_size;
+
+    memset(ptr, 0x00, size);
+    return ptr;
+}
+
+void arena_reset(struct Arena* arena, size_t mark)
+{
+    arena->used_ = mark;
+}
+
+struct Arena* arena_scratch()
+{
+    struct Task* task = task_current();
+    if (task)
+    {
+        return &task->scratch;
+    }
+
+    if (!BOOT_ARENA_.base_ && arena_init(&BOOT_ARENA_, KERNEL_SCRATCH_ARENA_SIZE) < 0)
+    {
+        panic("Error: arena_scratch");
+    }
+
+    return &BOOT_ARENA_;
+}
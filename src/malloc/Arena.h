@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+Bump-pointer arena for short-lived temporaries (path parts, directory buffers, headers).
+
+    struct Arena* scratch = arena_scratch();
+    size_t mark = arena_begin(scratch);
+    ... arena_alloc(scratch, size) ...
+    arena_reset(scratch, mark);
+
+Scopes nest, everything allocated after a mark is released together by arena_reset. Nothing is freed one by one.
+*/
+
+#define ARENA_ALIGNMENT 8
+
+struct Arena {
+    char *base_;
+    size_t size_;
+    size_t used_;
+};
+
+// Backs the arena with size bytes of kernel heap.
+extern int arena_init(struct Arena *arena, size_t size);
+
+extern void arena_release(struct Arena *arena);
+
+// Opens a scope, the returned mark is handed to arena_reset.
+extern size_t arena_begin(struct Arena *arena);
+
+// Zeroed, ARENA_ALIGNMENT aligned memory. 0 when the arena is full.
+extern void *arena_alloc(struct Arena *arena, size_t size);
+
+extern void arena_reset(struct Arena *arena, size_t mark);
+
+// The current task's scratch arena, or the boot arena before the first task runs.
+extern struct Arena *arena_scratch();
+
+#endif
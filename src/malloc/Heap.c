@@ -1,10 +1,15 @@
 #include "Heap.h"
+#include "HeapBitmap.h"
 #include "Kernel.h"
 #include "Status.h"
 #include "memory/Memory.h"
 #include "vga/Vga.h"
 #include <stdbool.h>
 
+#ifdef HEAP_SCAN_STATS
+uint32_t HEAP_SCAN_LENGTH_ = 0;
+#endif
+
 static int heap_validate_map(void* ptr, void* end, struct HeapMap* map)
 {
     int res = 0;
@@ -28,7 +33,9 @@ static bool heap_validate_alignment(void* ptr)
     return ((unsigned int)ptr % HEAP_BLOCK_SIZE) == 0;
 }
 
-int heap_create(struct Heap* heap, void* heapBaseAddr, void* end, struct HeapMap* map)
+static void heap_buddy_release_range(struct Heap* heap, int start_block, int total_blocks);
+
+int heap_create(struct Heap* heap, void* heapBaseAddr, void* end, struct HeapMap* map, int policy)
 {
     int res = 0;
 
@@ -39,9 +46,32 @@ int heap_create(struct Heap* heap, void* heapBaseAddr, void* end, struct HeapMap
         goto out;
     }
 
+    if (policy < HEAP_POLICY_FIRST_FIT || policy > HEAP_POLICY_CACHED)
+    {
+        res = -EINVARG;
+        log("Error: heap_create policy");
+        goto out;
+    }
+
+    if (map->encoding_ != HEAP_MAP_ENCODING_BYTEMAP && map->encoding_ != HEAP_MAP_ENCODING_BITMAP)
+    {
+        res = -EINVARG;
+        log("Error: heap_create map encoding");
+        goto out;
+    }
+
+    // Buddy free run heads keep their order in the map entry, only the bytemap has room for it.
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP && policy == HEAP_POLICY_BUDDY)
+    {
+        res = -EINVARG;
+        log("Error: heap_create map encoding");
+        goto out;
+    }
+
     memset(heap, 0, sizeof(struct Heap));
     heap->heapBaseAddr_ = heapBaseAddr;
     heap->heapMap_ = map;
+    heap->policy_ = policy;
 
     res = heap_validate_map(heapBaseAddr, end, map);
     if (res < 0)
@@ -50,13 +80,36 @@ int heap_create(struct Heap* heap, void* heapBaseAddr, void* end, struct HeapMap
         goto out;
     }
 
-    size_t table_size = sizeof(unsigned char) * map->totalEntries_;
-    memset(map->mapBaseAddress_, HEAP_MAP_ENTRY_FREE, table_size);
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        heap_bitmap_init(map);
+    }
+    else
+    {
+        size_t table_size = sizeof(unsigned char) * map->totalEntries_;
+        memset(map->mapBaseAddress_, HEAP_MAP_ENTRY_FREE, table_size);
+    }
+
+    if (policy == HEAP_POLICY_BUDDY)
+    {
+        // The whole heap starts as a set of free power-of-two runs.
+        heap_buddy_release_range(heap, 0, map->totalEntries_);
+    }
 
 out:
     return res;
 }
 
+size_t heap_map_storage_size(int encoding, size_t total_blocks)
+{
+    if (encoding == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_storage_size(total_blocks);
+    }
+
+    return sizeof(unsigned char) * total_blocks;
+}
+
 static uint32_t heap_align_value_to_upper(uint32_t val)
 {
     if ((val % HEAP_BLOCK_SIZE) == 0)
@@ -71,17 +124,257 @@ static uint32_t heap_align_value_to_upper(uint32_t val)
 
 static int heap_get_entry_type(unsigned char entry)
 {
-    return entry & 0x0f;
+    return entry & HEAP_MAP_ENTRY_TYPE_MASK;
 }
 
-int heap_get_start_block(struct Heap* heap, uint32_t total_blocks)
+void* heap_block_to_address(struct Heap* heap, int block)
 {
-    struct HeapMap* map = heap->heapMap_;
-    int bc = 0;
+    return heap->heapBaseAddr_ + (block * HEAP_BLOCK_SIZE);
+}
+
+int heap_address_to_block(struct Heap* heap, void* address)
+{
+    return ((int)(address - heap->heapBaseAddr_)) / HEAP_BLOCK_SIZE;
+}
+
+//****************************************** Buddy Allocator ******************************************
+
+/*
+Every free run is 2^order blocks long and starts on a block index aligned to 2^order.
+The head entry of a free run is marked in the heap map as IS_FIRST with its order, the free list node lives in the
+run's own memory. The buddy of a run is found by flipping the order bit of its block index.
+
+Allocations of n blocks take a 2^k run (2^k >= n) and give the unused tail back, so a 3 block allocation costs
+exactly 3 blocks. Freeing splits the run into aligned power-of-two pieces and merges each with its free buddies.
+*/
+
+static int heap_buddy_order_for_blocks(uint32_t total_blocks)
+{
+    int order = 0;
+    while ((1U << order) < total_blocks)
+    {
+        order++;
+    }
+
+    return order;
+}
+
+static bool heap_buddy_is_free_head(struct Heap* heap, int block, int order)
+{
+    unsigned char entry = heap->heapMap_->mapBaseAddress_[block];
+
+    return heap_get_entry_type(entry) == HEAP_MAP_ENTRY_FREE && (entry & HEAP_MAP_ENTRY_IS_FIRST)
+           && ((entry & HEAP_MAP_ENTRY_ORDER_MASK) >> HEAP_MAP_ENTRY_ORDER_SHIFT) == order;
+}
+
+static void heap_buddy_push(struct Heap* heap, int block, int order)
+{
+    struct HeapBuddyNode* node = heap_block_to_address(heap, block);
+
+    node->prev_ = 0;
+    node->next_ = heap->freeLists_[order];
+    if (node->next_)
+    {
+        node->next_->prev_ = node;
+    }
+    heap->freeLists_[order] = node;
+
+    heap->heapMap_->mapBaseAddress_[block] = HEAP_MAP_ENTRY_IS_FIRST | (order << HEAP_MAP_ENTRY_ORDER_SHIFT);
+}
+
+static void heap_buddy_unlink(struct Heap* heap, int block, int order)
+{
+    struct HeapBuddyNode* node = heap_block_to_address(heap, block);
+
+    if (node->prev_)
+    {
+        node->prev_->next_ = node->next_;
+    }
+    else
+    {
+        heap->freeLists_[order] = node->next_;
+    }
+
+    if (node->next_)
+    {
+        node->next_->prev_ = node->prev_;
+    }
+
+    heap->heapMap_->mapBaseAddress_[block] = HEAP_MAP_ENTRY_FREE;
+}
+
+// Largest order that starts at this block and still fits before end_block.
+static int heap_buddy_largest_order_at(int block, int end_block)
+{
+    int order = 0;
+    while (order < HEAP_BUDDY_MAX_ORDER && (block & (1 << order)) == 0 && block + (2 << order) <= end_block)
+    {
+        order++;
+    }
+
+    return order;
+}
+
+// Puts a range back on the free lists without merging, used for split remainders whose buddies are known taken.
+static void heap_buddy_release_range(struct Heap* heap, int start_block, int total_blocks)
+{
+    int end_block = start_block + total_blocks;
+    while (start_block < end_block)
+    {
+        int order = heap_buddy_largest_order_at(start_block, end_block);
+        heap_buddy_push(heap, start_block, order);
+        start_block += 1 << order;
+    }
+}
+
+static void heap_buddy_free_run(struct Heap* heap, int block, int order)
+{
+    int total_blocks = (int)heap->heapMap_->totalEntries_;
+
+    while (order < HEAP_BUDDY_MAX_ORDER)
+    {
+        int buddy = block ^ (1 << order);
+        if (buddy + (1 << order) > total_blocks || !heap_buddy_is_free_head(heap, buddy, order))
+        {
+            break;
+        }
+
+        heap_buddy_unlink(heap, buddy, order);
+        if (buddy < block)
+        {
+            block = buddy;
+        }
+        order++;
+    }
+
+    heap_buddy_push(heap, block, order);
+}
+
+static void heap_buddy_free_range(struct Heap* heap, int start_block, int total_blocks)
+{
+    int end_block = start_block + total_blocks;
+    while (start_block < end_block)
+    {
+        int order = heap_buddy_largest_order_at(start_block, end_block);
+        heap_buddy_free_run(heap, start_block, order);
+        start_block += 1 << order;
+    }
+}
+
+// Takes [start_block, start_block + total_blocks) off the free lists, the blocks must all be free.
+// Free runs that stick out of the range are split and their outside parts go back.
+static void heap_buddy_claim_range(struct Heap* heap, int start_block, int total_blocks)
+{
+    int end_block = start_block + total_blocks;
+    int block = start_block;
+
+    while (block < end_block)
+    {
+        // Find the free run that contains block, its head is aligned to its order.
+        int order = 0;
+        int head = block;
+        while (order <= HEAP_BUDDY_MAX_ORDER)
+        {
+            head = block & ~((1 << order) - 1);
+            if (heap_buddy_is_free_head(heap, head, order))
+            {
+                break;
+            }
+            order++;
+        }
+
+        if (order > HEAP_BUDDY_MAX_ORDER)
+        {
+            panic("Error: heap_buddy_claim_range block is not free");
+        }
+
+        int run_end = head + (1 << order);
+        heap_buddy_unlink(heap, head, order);
+        heap_buddy_free_range(heap, head, block - head);
+        if (run_end > end_block)
+        {
+            heap_buddy_free_range(heap, end_block, run_end - end_block);
+        }
+
+        block = run_end;
+    }
+}
+
+static int heap_buddy_get_start_block(struct Heap* heap, uint32_t total_blocks)
+{
+    int order = heap_buddy_order_for_blocks(total_blocks);
+    if (order > HEAP_BUDDY_MAX_ORDER)
+    {
+        return -ENOMEM;
+    }
+
+    int found_order = order;
+    while (found_order <= HEAP_BUDDY_MAX_ORDER && !heap->freeLists_[found_order])
+    {
+        HEAP_SCAN_COUNT(1);
+        found_order++;
+    }
+
+    if (found_order > HEAP_BUDDY_MAX_ORDER)
+    {
+        log("no memory");
+        return -ENOMEM;
+    }
+
+    int block = heap_address_to_block(heap, heap->freeLists_[found_order]);
+    heap_buddy_unlink(heap, block, found_order);
+
+    // Split the run down to the requested order, upper halves go back to the free lists.
+    while (found_order > order)
+    {
+        found_order--;
+        heap_buddy_push(heap, block + (1 << found_order), found_order);
+    }
+
+    // Give back the tail of the 2^order run that the allocation does not use.
+    heap_buddy_release_range(heap, block + total_blocks, (1 << order) - total_blocks);
+
+    return block;
+}
+
+//****************************************** Buddy Allocator ******************************************
+
+static bool heap_map_is_taken(struct HeapMap* map, int block)
+{
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_is_taken(map, block);
+    }
+
+    return heap_get_entry_type(map->mapBaseAddress_[block]) == HEAP_MAP_ENTRY_TAKEN;
+}
+
+// True for the first block of a taken run.
+static bool heap_map_is_first(struct HeapMap* map, int block)
+{
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_is_first(map, block);
+    }
+
+    unsigned char entry = map->mapBaseAddress_[block];
+    return heap_get_entry_type(entry) == HEAP_MAP_ENTRY_TAKEN && (entry & HEAP_MAP_ENTRY_IS_FIRST);
+}
+
+// First free run of total_blocks at or after from_block, -ENOMEM if there is none.
+static int heap_find_free_run(struct HeapMap* map, int from_block, uint32_t total_blocks)
+{
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_find_free_run(map, from_block, total_blocks);
+    }
+
+    uint32_t bc = 0;
     int bs = -1;
 
-    for (size_t i = 0; i < map->totalEntries_; i++)
+    for (size_t i = from_block; i < map->totalEntries_; i++)
     {
+        HEAP_SCAN_COUNT(1);
         if (heap_get_entry_type(map->mapBaseAddress_[i]) != HEAP_MAP_ENTRY_FREE)
         {
             bc = 0;
@@ -101,22 +394,135 @@ int heap_get_start_block(struct Heap* heap, uint32_t total_blocks)
         }
     }
 
-    if (bs == -1)
+    if (bs == -1 || bc != total_blocks)
     {
-        log("no memory");
         return -ENOMEM;
     }
 
     return bs;
 }
 
-void* heap_block_to_address(struct Heap* heap, int block)
+static int heap_first_fit_get_start_block(struct Heap* heap, uint32_t total_blocks)
 {
-    return heap->heapBaseAddr_ + (block * HEAP_BLOCK_SIZE);
+    int block = heap_find_free_run(heap->heapMap_, 0, total_blocks);
+    if (block < 0)
+    {
+        log("no memory");
+    }
+
+    return block;
+}
+
+// Resumes the scan where the last allocation ended and wraps around once.
+static int heap_next_fit_get_start_block(struct Heap* heap, uint32_t total_blocks)
+{
+    int block = heap_find_free_run(heap->heapMap_, heap->nextFitBlock_, total_blocks);
+    if (block < 0 && heap->nextFitBlock_ > 0)
+    {
+        block = heap_find_free_run(heap->heapMap_, 0, total_blocks);
+    }
+
+    if (block < 0)
+    {
+        log("no memory");
+        return block;
+    }
+
+    heap->nextFitBlock_ = block + total_blocks;
+    if (heap->nextFitBlock_ >= (int)heap->heapMap_->totalEntries_)
+    {
+        heap->nextFitBlock_ = 0;
+    }
+
+    return block;
+}
+
+//****************************************** Free Run Cache ******************************************
+
+/*
+Runs of up to HEAP_CACHE_MAX_BLOCKS blocks are remembered by size when freed, the next allocation of the same size
+takes the most recent one without scanning. The map stays the source of truth: runs are marked free as usual and
+a cached run is checked again before reuse, since a scan may have handed out part of it in the meantime.
+*/
+
+static void heap_cache_push(struct Heap* heap, int block, int total_blocks)
+{
+    if (total_blocks > HEAP_CACHE_MAX_BLOCKS)
+    {
+        return;
+    }
+
+    struct HeapRunCache* cache = &heap->runCaches_[total_blocks - 1];
+    if (cache->count_ == HEAP_CACHE_DEPTH)
+    {
+        // Drop the oldest run, it stays free in the map.
+        for (int i = 1; i < HEAP_CACHE_DEPTH; i++)
+        {
+            cache->blocks_[i - 1] = cache->blocks_[i];
+        }
+        cache->count_--;
+    }
+
+    cache->blocks_[cache->count_++] = block;
+}
+
+static bool heap_range_is_free(struct HeapMap* map, int block, uint32_t total_blocks)
+{
+    for (uint32_t i = 0; i < total_blocks; i++)
+    {
+        HEAP_SCAN_COUNT(1);
+        if (heap_map_is_taken(map, block + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int heap_cache_get_start_block(struct Heap* heap, uint32_t total_blocks)
+{
+    if (total_blocks <= HEAP_CACHE_MAX_BLOCKS)
+    {
+        struct HeapRunCache* cache = &heap->runCaches_[total_blocks - 1];
+        while (cache->count_ > 0)
+        {
+            int block = cache->blocks_[--cache->count_];
+            if (heap_range_is_free(heap->heapMap_, block, total_blocks))
+            {
+                return block;
+            }
+        }
+    }
+
+    return heap_next_fit_get_start_block(heap, total_blocks);
+}
+
+//****************************************** Free Run Cache ******************************************
+
+int heap_get_start_block(struct Heap* heap, uint32_t total_blocks)
+{
+    switch (heap->policy_)
+    {
+    case HEAP_POLICY_BUDDY:
+        return heap_buddy_get_start_block(heap, total_blocks);
+    case HEAP_POLICY_NEXT_FIT:
+        return heap_next_fit_get_start_block(heap, total_blocks);
+    case HEAP_POLICY_CACHED:
+        return heap_cache_get_start_block(heap, total_blocks);
+    }
+
+    return heap_first_fit_get_start_block(heap, total_blocks);
 }
 
 void heap_mark_blocks_taken(struct Heap* heap, int start_block, int total_blocks)
 {
+    if (heap->heapMap_->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        heap_bitmap_mark_taken(heap->heapMap_, start_block, total_blocks);
+        return;
+    }
+
     int end_block = (start_block + total_blocks) - 1;
 
     unsigned char entry = HEAP_MAP_ENTRY_TAKEN | HEAP_MAP_ENTRY_IS_FIRST;
@@ -140,6 +546,11 @@ void* heap_malloc_blocks(struct Heap* heap, uint32_t total_blocks)
 {
     void* address = 0;
 
+    if (total_blocks == 0)
+    {
+        goto out;
+    }
+
     int start_block = heap_get_start_block(heap, total_blocks);
     if (start_block < 0)
     {
@@ -151,30 +562,59 @@ void* heap_malloc_blocks(struct Heap* heap, uint32_t total_blocks)
     // Mark the blocks as taken
     heap_mark_blocks_taken(heap, start_block, total_blocks);
 
+    heap->allocations_++;
+    heap->usedBlocks_ += total_blocks;
+    if (heap->usedBlocks_ > heap->peakUsedBlocks_)
+    {
+        heap->peakUsedBlocks_ = heap->usedBlocks_;
+    }
+
 out:
     return address;
 }
 
-void heap_mark_blocks_free(struct Heap* heap, int starting_block)
+// Frees the run starting at starting_block, returns the number of blocks released.
+int heap_mark_blocks_free(struct Heap* heap, int starting_block)
 {
     struct HeapMap* map = heap->heapMap_;
+    int total_blocks = 0;
+
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_mark_free(map, starting_block);
+    }
 
     for (int i = starting_block; i < (int)map->totalEntries_; i++)
     {
         unsigned char entry = map->mapBaseAddress_[i];
 
         map->mapBaseAddress_[i] = HEAP_MAP_ENTRY_FREE;
-        
+        total_blocks++;
+
         if (!(entry & HEAP_MAP_ENTRY_HAS_NEXT))
         {
             break;
         }
     }
+
+    return total_blocks;
 }
 
-int heap_address_to_block(struct Heap* heap, void* address)
+// Number of blocks in the taken run starting at start_block.
+static int heap_run_length(struct HeapMap* map, int start_block)
 {
-    return ((int)(address - heap->heapBaseAddr_)) / HEAP_BLOCK_SIZE;
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        return heap_bitmap_run_length(map, start_block);
+    }
+
+    int total_blocks = 1;
+    for (int i = start_block; map->mapBaseAddress_[i] & HEAP_MAP_ENTRY_HAS_NEXT; i++)
+    {
+        total_blocks++;
+    }
+
+    return total_blocks;
 }
 
 void* heap_malloc(struct Heap* heap, size_t size)
@@ -186,5 +626,213 @@ void* heap_malloc(struct Heap* heap, size_t size)
 
 void heap_free(struct Heap* heap, void* ptr)
 {
-    heap_mark_blocks_free(heap, heap_address_to_block(heap, ptr));
-}
\ No newline at end of file
+    int block = heap_address_to_block(heap, ptr);
+    if (ptr < heap->heapBaseAddr_ || block >= (int)heap->heapMap_->totalEntries_)
+    {
+        return;
+    }
+
+    // Only the first block of a taken run can be freed, anything else is a double or a wild free.
+    if (!heap_map_is_first(heap->heapMap_, block))
+    {
+        log("Error: heap_free invalid pointer");
+        return;
+    }
+
+    int total_blocks = heap_mark_blocks_free(heap, block);
+    heap->frees_++;
+    heap->usedBlocks_ -= total_blocks;
+
+    if (heap->policy_ == HEAP_POLICY_BUDDY)
+    {
+        heap_buddy_free_range(heap, block, total_blocks);
+    }
+    else if (heap->policy_ == HEAP_POLICY_CACHED)
+    {
+        heap_cache_push(heap, block, total_blocks);
+    }
+}
+
+// Resizes the run at block in place, the blocks it grows into must be free.
+static void heap_resize_in_place(struct Heap* heap, int block, int old_blocks, int new_blocks)
+{
+    if (new_blocks > old_blocks && heap->policy_ == HEAP_POLICY_BUDDY)
+    {
+        heap_buddy_claim_range(heap, block + old_blocks, new_blocks - old_blocks);
+    }
+
+    heap_mark_blocks_free(heap, block);
+    heap_mark_blocks_taken(heap, block, new_blocks);
+
+    if (new_blocks < old_blocks && heap->policy_ == HEAP_POLICY_BUDDY)
+    {
+        heap_buddy_free_range(heap, block + new_blocks, old_blocks - new_blocks);
+    }
+
+    heap->usedBlocks_ += new_blocks - old_blocks;
+    if (heap->usedBlocks_ > heap->peakUsedBlocks_)
+    {
+        heap->peakUsedBlocks_ = heap->usedBlocks_;
+    }
+}
+
+bool heap_resize(struct Heap* heap, void* ptr, size_t size)
+{
+    struct HeapMap* map = heap->heapMap_;
+    int block = heap_address_to_block(heap, ptr);
+    if (size == 0 || ptr < heap->heapBaseAddr_ || block >= (int)map->totalEntries_ || !heap_map_is_first(map, block))
+    {
+        log("Error: heap_resize invalid pointer");
+        return false;
+    }
+
+    int old_blocks = heap_run_length(map, block);
+    int new_blocks = heap_align_value_to_upper(size) / HEAP_BLOCK_SIZE;
+    if (new_blocks == old_blocks)
+    {
+        return true;
+    }
+
+    // Grow in place while the blocks following the run are free.
+    bool in_place = new_blocks < old_blocks || block + new_blocks <= (int)map->totalEntries_;
+    for (int i = block + old_blocks; in_place && i < block + new_blocks; i++)
+    {
+        in_place = !heap_map_is_taken(map, i);
+    }
+
+    if (in_place)
+    {
+        heap_resize_in_place(heap, block, old_blocks, new_blocks);
+    }
+
+    return in_place;
+}
+
+void* heap_realloc(struct Heap* heap, void* ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return heap_malloc(heap, size);
+    }
+
+    if (size == 0)
+    {
+        heap_free(heap, ptr);
+        return 0;
+    }
+
+    size_t old_size = heap_allocation_size(heap, ptr);
+    if (old_size == 0)
+    {
+        log("Error: heap_realloc invalid pointer");
+        return 0;
+    }
+
+    if (heap_resize(heap, ptr, size))
+    {
+        return ptr;
+    }
+
+    void* new_ptr = heap_malloc(heap, size);
+    if (!new_ptr)
+    {
+        return 0;
+    }
+
+    memcpy(new_ptr, ptr, old_size);
+    heap_free(heap, ptr);
+    return new_ptr;
+}
+
+size_t heap_allocation_size(struct Heap* heap, void* ptr)
+{
+    int block = heap_address_to_block(heap, ptr);
+    if (ptr < heap->heapBaseAddr_ || block >= (int)heap->heapMap_->totalEntries_ || !heap_map_is_first(heap->heapMap_, block))
+    {
+        return 0;
+    }
+
+    return heap_run_length(heap->heapMap_, block) * HEAP_BLOCK_SIZE;
+}
+
+void* heap_get_allocation_base(struct Heap* heap, void* ptr)
+{
+    if (ptr < heap->heapBaseAddr_)
+    {
+        return 0;
+    }
+
+    int block = heap_address_to_block(heap, ptr);
+    if (block >= (int)heap->heapMap_->totalEntries_)
+    {
+        return 0;
+    }
+
+    struct HeapMap* map = heap->heapMap_;
+    if (!heap_map_is_taken(map, block))
+    {
+        return 0;
+    }
+
+    // Walk back to the first block of the run.
+    if (map->encoding_ == HEAP_MAP_ENCODING_BITMAP)
+    {
+        block = heap_bitmap_run_start(map, block);
+    }
+    else
+    {
+        while (block > 0 && !(map->mapBaseAddress_[block] & HEAP_MAP_ENTRY_IS_FIRST))
+        {
+            block--;
+        }
+    }
+
+    return heap_block_to_address(heap, block);
+}
+
+static void heap_stats_add_free_run(struct HeapStats* stats, uint32_t run)
+{
+    if (run == 0)
+    {
+        return;
+    }
+
+    int bucket = 0;
+    while (bucket < HEAP_STATS_HISTOGRAM_BUCKETS - 1 && (run >> (bucket + 1)) != 0)
+    {
+        bucket++;
+    }
+
+    stats->freeRuns_[bucket]++;
+    if (run > stats->largestFreeRun_)
+    {
+        stats->largestFreeRun_ = run;
+    }
+}
+
+void heap_get_stats(struct Heap* heap, struct HeapStats* stats)
+{
+    struct HeapMap* map = heap->heapMap_;
+
+    memset(stats, 0, sizeof(struct HeapStats));
+    stats->totalBlocks_ = map->totalEntries_;
+    stats->usedBlocks_ = heap->usedBlocks_;
+    stats->freeBlocks_ = map->totalEntries_ - heap->usedBlocks_;
+    stats->peakUsedBlocks_ = heap->peakUsedBlocks_;
+    stats->allocations_ = heap->allocations_;
+    stats->frees_ = heap->frees_;
+
+    // Buddy free runs are split into aligned pieces, merge neighbours so the numbers compare across policies.
+    uint32_t run = 0;
+    for (size_t i = 0; i < map->totalEntries_; i++)
+    {
+        if (heap_map_is_taken(map, i))
+        {
+            heap_stats_add_free_run(stats, run);
+            run = 0;
+            continue;
+        }
+        run++;
+    }
+    heap_stats_add_free_run(stats, run);
+}
@@ -4,6 +4,7 @@
 #include "Memory_Constants.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 
 // Bit pipes of heap table entry
@@ -14,22 +15,110 @@
 #define HEAP_MAP_ENTRY_HAS_NEXT 0b10000000
 #define HEAP_MAP_ENTRY_IS_FIRST 0b01000000
 
+// Entry type lives in the lowest bit, bits 1-5 hold the buddy order of a free run head.
+#define HEAP_MAP_ENTRY_TYPE_MASK 0b00000001
+#define HEAP_MAP_ENTRY_ORDER_MASK 0b00111110
+#define HEAP_MAP_ENTRY_ORDER_SHIFT 1
+
+
+// Allocation policies, selected at heap_create.
+#define HEAP_POLICY_FIRST_FIT 0 // Linear scan of the heap map from block 0.
+#define HEAP_POLICY_BUDDY 1     // Power-of-two buddy free lists, O(log n) allocation and coalescing free. Split
+                                // tails fragment the heap under mixed run sizes.
+#define HEAP_POLICY_NEXT_FIT 2  // Linear scan resumed from the end of the previous allocation.
+#define HEAP_POLICY_CACHED 3    // Recently freed runs reused by size in O(1), next-fit otherwise.
+
+// Cached policy: remembered runs per size, for sizes of 1 to HEAP_CACHE_MAX_BLOCKS blocks.
+#define HEAP_CACHE_MAX_BLOCKS 8
+#define HEAP_CACHE_DEPTH 8
+
+// Heap map encodings, selected through HeapMap.encoding_ before heap_create.
+#define HEAP_MAP_ENCODING_BYTEMAP 0 // One entry byte per block, required by the buddy policy.
+#define HEAP_MAP_ENCODING_BITMAP 1  // Taken and has next bitmaps with a summary of full 128KB regions, see HeapBitmap.h.
+
+// 2^20 blocks * 4KB = 4GB, the whole 32 bit address space.
+#define HEAP_BUDDY_MAX_ORDER 20
+
+// Map entries (bitmap words, buddy free lists) examined while searching for a free run. Only counted in builds with
+// HEAP_SCAN_STATS, i.e. the host benchmark in tools/heap_bench.
+#ifdef HEAP_SCAN_STATS
+extern uint32_t HEAP_SCAN_LENGTH_;
+#define HEAP_SCAN_COUNT(entries) (HEAP_SCAN_LENGTH_ += (entries))
+#else
+#define HEAP_SCAN_COUNT(entries)
+#endif
+
 
 struct HeapMap {
     unsigned char *mapBaseAddress_;
     size_t totalEntries_;
+    int encoding_;
+    uint32_t *takenBits_;   // Bitmap encoding only, carved from mapBaseAddress_ by heap_create.
+    uint32_t *hasNextBits_;
+    uint32_t *fullBits_;
 };
 
+// Free list node, stored in the first bytes of every free buddy run.
+struct HeapBuddyNode {
+    struct HeapBuddyNode *next_;
+    struct HeapBuddyNode *prev_;
+};
+
+// Free run histogram buckets: 1, 2-3, 4-7 ... 2^15 and more blocks.
+#define HEAP_STATS_HISTOGRAM_BUCKETS 16
+
+// Snapshot of a heap, counts are in blocks unless noted. Layout is shared with user programs, keep it 32 bit fields.
+struct HeapStats {
+    uint32_t totalBlocks_;
+    uint32_t usedBlocks_;
+    uint32_t freeBlocks_;
+    uint32_t peakUsedBlocks_;
+    uint32_t largestFreeRun_;
+    uint32_t freeRuns_[HEAP_STATS_HISTOGRAM_BUCKETS]; // Number of free runs per size bucket.
+    uint32_t allocations_;                             // Successful heap_malloc calls since heap_create.
+    uint32_t frees_;                                   // Valid heap_free calls since heap_create.
+};
+
+// Start blocks of recently freed runs of one size, the newest last.
+struct HeapRunCache {
+    int blocks_[HEAP_CACHE_DEPTH];
+    int count_;
+};
 
 struct Heap {
     struct HeapMap *heapMap_;
     void *heapBaseAddr_;
+    int policy_;
+    struct HeapBuddyNode *freeLists_[HEAP_BUDDY_MAX_ORDER + 1]; // Free runs of 2^order blocks.
+    int nextFitBlock_;                                           // Next-fit and cached scan start.
+    struct HeapRunCache runCaches_[HEAP_CACHE_MAX_BLOCKS];        // Cached policy, indexed by blocks - 1.
+    uint32_t usedBlocks_;
+    uint32_t peakUsedBlocks_;
+    uint32_t allocations_;
+    uint32_t frees_;
 };
 
-extern int heap_create(struct Heap *heap, void *ptr, void *end, struct HeapMap *table);
+extern int heap_create(struct Heap *heap, void *ptr, void *end, struct HeapMap *table, int policy);
+
+// Bytes of map storage needed at mapBaseAddress_ for total_blocks with the given encoding.
+extern size_t heap_map_storage_size(int encoding, size_t total_blocks);
 
 extern void *heap_malloc(struct Heap *heap, size_t size);
 
 extern void heap_free(struct Heap *heap, void *ptr);
 
-#endif
\ No newline at end of file
+// Grows or shrinks the allocation at ptr in place, false when the following blocks are taken. Never moves.
+extern bool heap_resize(struct Heap *heap, void *ptr, size_t size);
+
+// Grows or shrinks in place when the following blocks allow it, otherwise moves the data. 0 on failure, ptr stays valid.
+extern void *heap_realloc(struct Heap *heap, void *ptr, size_t size);
+
+extern void *heap_get_allocation_base(struct Heap *heap, void *ptr);
+
+// Bytes in the allocation that starts at ptr, 0 when ptr isn't the start of one.
+extern size_t heap_allocation_size(struct Heap *heap, void *ptr);
+
+// Walks the whole map, meant for diagnostics rather than hot paths.
+extern void heap_get_stats(struct Heap *heap, struct HeapStats *stats);
+
+#endif
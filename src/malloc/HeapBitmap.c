@@ -0,0 +1,227 @@
+#include "HeapBitmap.h"
+#include "Status.h"
+#include "memory/Memory.h"
+
+#define HEAP_BITMAP_FULL_WORD 0xFFFFFFFF
+
+static size_t heap_bitmap_words(size_t total_blocks)
+{
+    return (total_blocks + HEAP_BITMAP_WORD_BITS - 1) / HEAP_BITMAP_WORD_BITS;
+}
+
+// bsf, index of the lowest set bit, word must not be 0.
+static int heap_bitmap_lowest_bit(uint32_t word)
+{
+    return __builtin_ctz(word);
+}
+
+// bsr, index of the highest set bit, word must not be 0.
+static int heap_bitmap_highest_bit(uint32_t word)
+{
+    return (HEAP_BITMAP_WORD_BITS - 1) - __builtin_clz(word);
+}
+
+static bool heap_bitmap_test(uint32_t *bits, int index)
+{
+    return (bits[index / HEAP_BITMAP_WORD_BITS] >> (index % HEAP_BITMAP_WORD_BITS)) & 1;
+}
+
+static void heap_bitmap_set_range(uint32_t *bits, int start, int count, bool value)
+{
+    while (count > 0)
+    {
+        int word = start / HEAP_BITMAP_WORD_BITS;
+        int bit = start % HEAP_BITMAP_WORD_BITS;
+        int span = HEAP_BITMAP_WORD_BITS - bit;
+        if (span > count)
+        {
+            span = count;
+        }
+
+        uint32_t mask = span == HEAP_BITMAP_WORD_BITS ? HEAP_BITMAP_FULL_WORD : ((1U << span) - 1) << bit;
+        if (value)
+        {
+            bits[word] |= mask;
+        }
+        else
+        {
+            bits[word] &= ~mask;
+        }
+
+        start += span;
+        count -= span;
+    }
+}
+
+// Refreshes the full bits of the taken words that cover blocks [start, start + count).
+static void heap_bitmap_update_full(struct HeapMap *map, int start, int count)
+{
+    int first_word = start / HEAP_BITMAP_WORD_BITS;
+    int last_word = (start + count - 1) / HEAP_BITMAP_WORD_BITS;
+
+    for (int word = first_word; word <= last_word; word++)
+    {
+        heap_bitmap_set_range(map->fullBits_, word, 1, map->takenBits_[word] == HEAP_BITMAP_FULL_WORD);
+    }
+}
+
+// First taken word at or after word that still has a free block, skipping full words 32 at a time.
+static int heap_bitmap_next_open_word(struct HeapMap *map, int word)
+{
+    int total_words = (int)heap_bitmap_words(map->totalEntries_);
+
+    while (word < total_words)
+    {
+        HEAP_SCAN_COUNT(1);
+        int summary = word / HEAP_BITMAP_WORD_BITS;
+        uint32_t open = ~map->fullBits_[summary] & (HEAP_BITMAP_FULL_WORD << (word % HEAP_BITMAP_WORD_BITS));
+        if (open)
+        {
+            return summary * HEAP_BITMAP_WORD_BITS + heap_bitmap_lowest_bit(open);
+        }
+
+        word = (summary + 1) * HEAP_BITMAP_WORD_BITS;
+    }
+
+    return total_words;
+}
+
+size_t heap_bitmap_storage_size(size_t total_blocks)
+{
+    size_t words = heap_bitmap_words(total_blocks);
+    return (words * 2 + heap_bitmap_words(words)) * sizeof(uint32_t);
+}
+
+void heap_bitmap_init(struct HeapMap *map)
+{
+    size_t words = heap_bitmap_words(map->totalEntries_);
+
+    map->takenBits_ = (uint32_t *)map->mapBaseAddress_;
+    map->hasNextBits_ = map->takenBits_ + words;
+    map->fullBits_ = map->hasNextBits_ + words;
+    memset(map->mapBaseAddress_, 0, heap_bitmap_storage_size(map->totalEntries_));
+
+    // Padding bits past the last block are permanently taken so searches stop there.
+    int padding = (int)(words * HEAP_BITMAP_WORD_BITS - map->totalEntries_);
+    if (padding)
+    {
+        heap_bitmap_set_range(map->takenBits_, map->totalEntries_, padding, true);
+        heap_bitmap_update_full(map, map->totalEntries_, padding);
+    }
+}
+
+bool heap_bitmap_is_taken(struct HeapMap *map, int block)
+{
+    return heap_bitmap_test(map->takenBits_, block);
+}
+
+bool heap_bitmap_is_first(struct HeapMap *map, int block)
+{
+    if (!heap_bitmap_is_taken(map, block))
+    {
+        return false;
+    }
+
+    return block == 0 || !heap_bitmap_test(map->hasNextBits_, block - 1);
+}
+
+int heap_bitmap_find_free_run(struct HeapMap *map, int from_block, int total_blocks)
+{
+    int total_words = (int)heap_bitmap_words(map->totalEntries_);
+    int end_limit = (int)map->totalEntries_;
+    int block = from_block;
+
+    while (block < end_limit)
+    {
+        // Start of the next free run.
+        int word = block / HEAP_BITMAP_WORD_BITS;
+        uint32_t free_bits = ~map->takenBits_[word] & (HEAP_BITMAP_FULL_WORD << (block % HEAP_BITMAP_WORD_BITS));
+        HEAP_SCAN_COUNT(1);
+        while (!free_bits)
+        {
+            word = heap_bitmap_next_open_word(map, word + 1);
+            if (word >= total_words)
+            {
+                return -ENOMEM;
+            }
+            free_bits = ~map->takenBits_[word];
+            HEAP_SCAN_COUNT(1);
+        }
+
+        int start = word * HEAP_BITMAP_WORD_BITS + heap_bitmap_lowest_bit(free_bits);
+
+        // End of that run, empty words are crossed 32 blocks at a time.
+        uint32_t taken_bits = map->takenBits_[word] & (HEAP_BITMAP_FULL_WORD << (start % HEAP_BITMAP_WORD_BITS));
+        while (!taken_bits && ++word < total_words)
+        {
+            HEAP_SCAN_COUNT(1);
+            taken_bits = map->takenBits_[word];
+        }
+
+        int end = taken_bits ? word * HEAP_BITMAP_WORD_BITS + heap_bitmap_lowest_bit(taken_bits) : end_limit;
+        if (end - start >= total_blocks)
+        {
+            return start;
+        }
+
+        block = end;
+    }
+
+    return -ENOMEM;
+}
+
+void heap_bitmap_mark_taken(struct HeapMap *map, int start_block, int total_blocks)
+{
+    heap_bitmap_set_range(map->takenBits_, start_block, total_blocks, true);
+    heap_bitmap_set_range(map->hasNextBits_, start_block, total_blocks - 1, true);
+    heap_bitmap_set_range(map->hasNextBits_, start_block + total_blocks - 1, 1, false);
+    heap_bitmap_update_full(map, start_block, total_blocks);
+}
+
+int heap_bitmap_run_length(struct HeapMap *map, int start_block)
+{
+    int total_words = (int)heap_bitmap_words(map->totalEntries_);
+
+    // The run ends on the first block without a has next bit.
+    int word = start_block / HEAP_BITMAP_WORD_BITS;
+    uint32_t last_bits = ~map->hasNextBits_[word] & (HEAP_BITMAP_FULL_WORD << (start_block % HEAP_BITMAP_WORD_BITS));
+    while (!last_bits && ++word < total_words)
+    {
+        last_bits = ~map->hasNextBits_[word];
+    }
+
+    int end_block = last_bits ? word * HEAP_BITMAP_WORD_BITS + heap_bitmap_lowest_bit(last_bits) : (int)map->totalEntries_ - 1;
+    return end_block - start_block + 1;
+}
+
+int heap_bitmap_mark_free(struct HeapMap *map, int start_block)
+{
+    int total_blocks = heap_bitmap_run_length(map, start_block);
+
+    heap_bitmap_set_range(map->takenBits_, start_block, total_blocks, false);
+    heap_bitmap_set_range(map->hasNextBits_, start_block, total_blocks, false);
+    heap_bitmap_update_full(map, start_block, total_blocks);
+
+    return total_blocks;
+}
+
+int heap_bitmap_run_start(struct HeapMap *map, int block)
+{
+    if (block == 0)
+    {
+        return 0;
+    }
+
+    // The run starts right after the last block before it without a has next bit.
+    int index = block - 1;
+    int word = index / HEAP_BITMAP_WORD_BITS;
+    int bit = index % HEAP_BITMAP_WORD_BITS;
+    uint32_t mask = bit == HEAP_BITMAP_WORD_BITS - 1 ? HEAP_BITMAP_FULL_WORD : (1U << (bit + 1)) - 1;
+    uint32_t last_bits = ~map->hasNextBits_[word] & mask;
+    while (!last_bits && --word >= 0)
+    {
+        last_bits = ~map->hasNextBits_[word];
+    }
+
+    return last_bits ? word * HEAP_BITMAP_WORD_BITS + heap_bitmap_highest_bit(last_bits) + 1 : 0;
+}
@@ -0,0 +1,38 @@
+#ifndef HEAP_BITMAP_H
+#define HEAP_BITMAP_H
+
+#include "Heap.h"
+#include <stdbool.h>
+
+/*
+Bitmap Heap Map (HEAP_MAP_ENCODING_BITMAP) :
+
+Taken bits    : 1 bit per block, set while the block is allocated.
+Has next bits : 1 bit per block, set when the allocation continues into the next block.
+Full bits     : 1 bit per taken word, set when all 32 blocks (128KB) of the word are allocated.
+
+Free runs are found 32 blocks at a time with bsf/bsr, full 128KB regions are skipped through the full bits,
+a full word of full bits skips 4MB at once.
+*/
+
+#define HEAP_BITMAP_WORD_BITS 32
+
+extern size_t heap_bitmap_storage_size(size_t total_blocks);
+
+extern void heap_bitmap_init(struct HeapMap *map);
+
+extern bool heap_bitmap_is_taken(struct HeapMap *map, int block);
+
+extern bool heap_bitmap_is_first(struct HeapMap *map, int block);
+
+extern int heap_bitmap_find_free_run(struct HeapMap *map, int from_block, int total_blocks);
+
+extern void heap_bitmap_mark_taken(struct HeapMap *map, int start_block, int total_blocks);
+
+extern int heap_bitmap_run_length(struct HeapMap *map, int start_block);
+
+extern int heap_bitmap_mark_free(struct HeapMap *map, int start_block);
+
+extern int heap_bitmap_run_start(struct HeapMap *map, int block);
+
+#endif
@@ -1,40 +1,332 @@
 #include "Config.h"
-#include "Heap.h"
 #include "Kernel.h"
+#include "Kheap.h"
+#include "Slab.h"
 #include "memory/Memory.h"
+#include "pmm/Pmm.h"
 #include "vga/Vga.h"
 
 struct Heap KERNEL_HEAP_;
 struct HeapMap KERNEL_HEAP_MAP_;
 
+// Size classes 16, 32, 64 ... 2048 bytes for small kernel objects.
+static struct SlabCache KERNEL_SIZE_CACHES_[KERNEL_SLAB_SIZE_CLASSES];
+
+// Single zeroed blocks prepared ahead of time, kernel_zeroed_page_alloc takes from here before it zeroes inline.
+static void* KERNEL_ZERO_POOL_[KERNEL_ZERO_POOL_SIZE];
+static int KERNEL_ZERO_POOL_COUNT_ = 0;
+static uint32_t KERNEL_ZERO_POOL_HITS_ = 0;
+static uint32_t KERNEL_ZERO_POOL_MISSES_ = 0;
+
+#ifdef KERNEL_HEAP_TRACE
+static struct KernelHeapTraceRecord KERNEL_HEAP_TRACE_[KERNEL_HEAP_TRACE_SIZE];
+static uint32_t KERNEL_HEAP_TRACE_COUNT_ = 0; // Total records ever written, the ring index is count % size.
+
+static void kernel_heap_trace_record(uint8_t op, void* ptr, size_t size, void* caller)
+{
+    struct KernelHeapTraceRecord* record = &KERNEL_HEAP_TRACE_[KERNEL_HEAP_TRACE_COUNT_++ % KERNEL_HEAP_TRACE_SIZE];
+
+    __asm__ volatile("rdtsc" : "=A"(record->timestamp_));
+    record->caller_ = caller;
+    record->size_ = size;
+    record->block_ = ptr ? ((uint32_t)ptr - (uint32_t)KERNEL_HEAP_.heapBaseAddr_) / HEAP_BLOCK_SIZE : -1;
+    record->op_ = op;
+}
+
+// Expanded in the public kernel_* functions so the return address is their caller, not another kernel_* function.
+#define KERNEL_HEAP_TRACE_RECORD(op, ptr, size) kernel_heap_trace_record(op, ptr, size, __builtin_return_address(0))
+#else
+#define KERNEL_HEAP_TRACE_RECORD(op, ptr, size)
+#endif
+
+static void kernel_slab_init()
+{
+    for (int i = 0; i < KERNEL_SLAB_SIZE_CLASSES; i++)
+    {
+        size_t object_size = SLAB_MIN_OBJECT_SIZE << i;
+
+        // Large classes use 4 block slabs, otherwise a 2048 byte slab would hold a single object.
+        int slab_blocks = object_size >= 1024 ? 4 : 1;
+        if (slab_cache_init(&KERNEL_SIZE_CACHES_[i], "kmalloc", object_size, slab_blocks, 0) < 0)
+        {
+            panic("Error: kernel_slab_init");
+        }
+    }
+}
+
+static struct SlabCache* kernel_size_cache(size_t size)
+{
+    int i = 0;
+    while ((size_t)(SLAB_MIN_OBJECT_SIZE << i) < size)
+    {
+        i++;
+    }
+
+    return &KERNEL_SIZE_CACHES_[i];
+}
+
 void kernel_heap_init()
 {
-    KERNEL_HEAP_MAP_.mapBaseAddress_ = (unsigned char*)(HEAP_MAP_BASE_ADDRESS);
-    KERNEL_HEAP_MAP_.totalEntries_ = TOTAL_HEAP_MAP_BLOCKS;
+    size_t heap_size = (pmm_free_frame_count() * PMM_FRAME_SIZE / 100) * KERNEL_HEAP_RAM_PERCENT;
+    if (heap_size < KERNEL_HEAP_MIN_SIZE)
+    {
+        heap_size = KERNEL_HEAP_MIN_SIZE;
+    }
+
+    size_t total_blocks = heap_size / HEAP_BLOCK_SIZE;
+    size_t map_size = heap_map_storage_size(KERNEL_HEAP_MAP_ENCODING, total_blocks);
+
+    // Map and heap are both physically contiguous runs of PMM frames.
+    void* map = pmm_alloc_frames((map_size + PMM_FRAME_SIZE - 1) / PMM_FRAME_SIZE);
+    void* heap = pmm_alloc_frames(total_blocks);
+    if (!map || !heap)
+    {
+        panic("Error: kernel_heap_init not enough memory");
+    }
 
-    void* end = (void*)(HEAP_BASE_ADDRESS + TOTAL_HEAP_SIZE);
-    int res = heap_create(&KERNEL_HEAP_, (void*)(HEAP_BASE_ADDRESS), end, &KERNEL_HEAP_MAP_);
+    KERNEL_HEAP_MAP_.mapBaseAddress_ = (unsigned char*)map;
+    KERNEL_HEAP_MAP_.totalEntries_ = total_blocks;
+    KERNEL_HEAP_MAP_.encoding_ = KERNEL_HEAP_MAP_ENCODING;
+
+    void* end = heap + total_blocks * HEAP_BLOCK_SIZE;
+    int res = heap_create(&KERNEL_HEAP_, heap, end, &KERNEL_HEAP_MAP_, KERNEL_HEAP_POLICY);
     if (res < 0)
     {
         panic("Error: kernel_heap_init");
     }
+
+    logAddress("kernel heap size: ", total_blocks * HEAP_BLOCK_SIZE);
+
+    kernel_slab_init();
+
+    kernel_zero_pool_refill(KERNEL_ZERO_POOL_SIZE);
 }
 
-void* kernel_malloc(size_t size)
+static void* kernel_malloc_untraced(size_t size)
 {
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if (size <= KERNEL_SLAB_MAX_SIZE)
+    {
+        return slab_alloc(kernel_size_cache(size));
+    }
+
     return heap_malloc(&KERNEL_HEAP_, size);
 }
 
+static void kernel_free_untraced(void* ptr)
+{
+    if (!ptr) return;
+
+    // Slab objects are never block aligned.
+    if ((uint32_t)ptr % HEAP_BLOCK_SIZE)
+    {
+        slab_free(ptr);
+        return;
+    }
+
+    heap_free(&KERNEL_HEAP_, ptr);
+}
+
+void* kernel_malloc(size_t size)
+{
+    void* ptr = kernel_malloc_untraced(size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_ALLOC, ptr, size);
+    return ptr;
+}
+
 void* kernel_zeroed_alloc(size_t size)
 {
-    void* ptr = kernel_malloc(size);
+    void* ptr = kernel_malloc_untraced(size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_ALLOC, ptr, size);
     if (!ptr) return 0;
 
     memset(ptr, 0x00, size);
     return ptr;
 }
 
+static void* kernel_realloc_untraced(void* ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return kernel_malloc_untraced(size);
+    }
+
+    if (size == 0)
+    {
+        kernel_free_untraced(ptr);
+        return 0;
+    }
+
+    // Heap block allocation.
+    if ((uint32_t)ptr % HEAP_BLOCK_SIZE == 0)
+    {
+        return heap_realloc(&KERNEL_HEAP_, ptr, size);
+    }
+
+    size_t old_size = slab_object_size(ptr);
+    if (old_size == 0)
+    {
+        log("Error: kernel_realloc invalid pointer");
+        return 0;
+    }
+
+    if (size <= old_size)
+    {
+        return ptr;
+    }
+
+    void* new_ptr = kernel_malloc_untraced(size);
+    if (!new_ptr)
+    {
+        return 0;
+    }
+
+    memcpy(new_ptr, ptr, old_size);
+    slab_free(ptr);
+    return new_ptr;
+}
+
+void* kernel_realloc(void* ptr, size_t size)
+{
+    void* new_ptr = kernel_realloc_untraced(ptr, size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_REALLOC, new_ptr, size);
+    return new_ptr;
+}
+
+bool kernel_resize_page_alloc(void* ptr, size_t size)
+{
+    if ((uint32_t)ptr % HEAP_BLOCK_SIZE != 0)
+    {
+        return false;
+    }
+
+    bool res = heap_resize(&KERNEL_HEAP_, ptr, size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_REALLOC, res ? ptr : 0, size);
+    return res;
+}
+
+// Gives all pooled blocks back to the heap, used when the heap runs short.
+static bool kernel_zero_pool_drain()
+{
+    if (KERNEL_ZERO_POOL_COUNT_ == 0)
+    {
+        return false;
+    }
+
+    while (KERNEL_ZERO_POOL_COUNT_ > 0)
+    {
+        heap_free(&KERNEL_HEAP_, KERNEL_ZERO_POOL_[--KERNEL_ZERO_POOL_COUNT_]);
+    }
+
+    return true;
+}
+
+void kernel_zero_pool_refill(int budget)
+{
+    while (budget-- > 0 && KERNEL_ZERO_POOL_COUNT_ < KERNEL_ZERO_POOL_SIZE)
+    {
+        void* block = heap_malloc(&KERNEL_HEAP_, HEAP_BLOCK_SIZE);
+        if (!block)
+        {
+            return;
+        }
+
+        memset(block, 0x00, HEAP_BLOCK_SIZE);
+        KERNEL_ZERO_POOL_[KERNEL_ZERO_POOL_COUNT_++] = block;
+    }
+}
+
+static void* kernel_page_alloc_untraced(size_t size)
+{
+    void* ptr = heap_malloc(&KERNEL_HEAP_, size);
+    if (!ptr && kernel_zero_pool_drain())
+    {
+        ptr = heap_malloc(&KERNEL_HEAP_, size);
+    }
+
+    return ptr;
+}
+
+void* kernel_page_alloc(size_t size)
+{
+    void* ptr = kernel_page_alloc_untraced(size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_ALLOC, ptr, size);
+    return ptr;
+}
+
+void* kernel_zeroed_page_alloc(size_t size)
+{
+    if (size > 0 && size <= HEAP_BLOCK_SIZE)
+    {
+        if (KERNEL_ZERO_POOL_COUNT_ > 0)
+        {
+            KERNEL_ZERO_POOL_HITS_++;
+            void* block = KERNEL_ZERO_POOL_[--KERNEL_ZERO_POOL_COUNT_];
+            KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_ALLOC, block, size);
+            return block;
+        }
+        KERNEL_ZERO_POOL_MISSES_++;
+    }
+
+    void* ptr = kernel_page_alloc_untraced(size);
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_ALLOC, ptr, size);
+    if (!ptr) return 0;
+
+    memset(ptr, 0x00, size);
+    return ptr;
+}
+
+void* kernel_alloc_base(void* ptr)
+{
+    return heap_get_allocation_base(&KERNEL_HEAP_, ptr);
+}
+
 void kernel_free_alloc(void* ptr)
 {
-    heap_free(&KERNEL_HEAP_, ptr);
-}
\ No newline at end of file
+    if (!ptr) return;
+
+    KERNEL_HEAP_TRACE_RECORD(KERNEL_HEAP_TRACE_FREE, ptr, 0);
+    kernel_free_untraced(ptr);
+}
+
+void kernel_heap_get_stats(struct KernelHeapStats* stats)
+{
+    heap_get_stats(&KERNEL_HEAP_, &stats->heap_);
+    stats->zeroPoolBlocks_ = KERNEL_ZERO_POOL_COUNT_;
+    stats->zeroPoolHits_ = KERNEL_ZERO_POOL_HITS_;
+    stats->zeroPoolMisses_ = KERNEL_ZERO_POOL_MISSES_;
+}
+
+#ifdef KERNEL_HEAP_TRACE
+void kernel_heap_trace_dump(int max_records)
+{
+    static const char* op_names[] = {"alloc ", "free ", "realloc "};
+
+    uint32_t total = KERNEL_HEAP_TRACE_COUNT_ < KERNEL_HEAP_TRACE_SIZE ? KERNEL_HEAP_TRACE_COUNT_ : KERNEL_HEAP_TRACE_SIZE;
+    if (max_records >= 0 && (uint32_t)max_records < total)
+    {
+        total = max_records;
+    }
+
+    // Timestamps are printed as cycles since the previous dumped record.
+    uint64_t previous = 0;
+    for (uint32_t i = KERNEL_HEAP_TRACE_COUNT_ - total; i < KERNEL_HEAP_TRACE_COUNT_; i++)
+    {
+        struct KernelHeapTraceRecord* record = &KERNEL_HEAP_TRACE_[i % KERNEL_HEAP_TRACE_SIZE];
+
+        print(op_names[record->op_]);
+        print("+");
+        print(ptr_to_hex(previous ? (uint32_t)(record->timestamp_ - previous) : 0));
+        previous = record->timestamp_;
+        print(" size ");
+        print(ptr_to_hex(record->size_));
+        print(" block ");
+        print(record->block_ < 0 ? "none" : ptr_to_hex(record->block_));
+        logAddress(" caller ", (uint32_t)record->caller_);
+    }
+}
+#endif
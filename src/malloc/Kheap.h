@@ -3,13 +3,64 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "Config.h"
+#include "Heap.h"
 
+// Kernel heap snapshot plus the zero pool counters, copied out to user programs as is.
+struct KernelHeapStats {
+    struct HeapStats heap_;
+    uint32_t zeroPoolBlocks_; // Zeroed blocks currently in the pool.
+    uint32_t zeroPoolHits_;   // Zeroed block allocations served from the pool.
+    uint32_t zeroPoolMisses_; // Zeroed block allocations that had to memset inline.
+};
+
+// Reserves the heap and its map from the PMM, pmm_init must run first.
 extern void kernel_heap_init();
 
+// Small sizes come from slab size classes, the result is only heap block aligned above KERNEL_SLAB_MAX_SIZE.
 extern void *kernel_malloc(size_t size);
 
 extern void *kernel_zeroed_alloc(size_t size);
 
+// Heap block allocations grow in place when the following blocks are free, slab objects move once they outgrow
+// their size class. Returns 0 on failure and leaves ptr allocated.
+extern void *kernel_realloc(void *ptr, size_t size);
+
+// Resizes a kernel_page_alloc allocation without moving it, false when the following blocks are taken.
+extern bool kernel_resize_page_alloc(void *ptr, size_t size);
+
+// Always heap block (page) aligned, use for anything that gets mapped with paging.
+extern void *kernel_page_alloc(size_t size);
+
+extern void *kernel_zeroed_page_alloc(size_t size);
+
+// First heap block of the allocation that contains ptr.
+extern void *kernel_alloc_base(void *ptr);
+
 extern void kernel_free_alloc(void *ptr);
 
-#endif
\ No newline at end of file
+// Zeroes up to budget blocks into the zero pool, call where the kernel would otherwise wait.
+extern void kernel_zero_pool_refill(int budget);
+
+extern void kernel_heap_get_stats(struct KernelHeapStats *stats);
+
+#ifdef KERNEL_HEAP_TRACE
+#define KERNEL_HEAP_TRACE_ALLOC 0
+#define KERNEL_HEAP_TRACE_FREE 1
+#define KERNEL_HEAP_TRACE_REALLOC 2
+
+// One kernel heap call, kept in a ring of the last KERNEL_HEAP_TRACE_SIZE calls.
+struct KernelHeapTraceRecord {
+    uint64_t timestamp_; // rdtsc
+    void *caller_;       // Return address into the caller of the kernel_* function.
+    uint32_t size_;      // Requested size, 0 for frees.
+    int32_t block_;      // Heap block of the pointer (the slab's block for small objects), -1 when the call failed.
+    uint8_t op_;
+};
+
+// Prints the last max_records calls, oldest first. Callers are link addresses of kernel.bin, resolve them with
+// addr2line -f -e ./build/kernel.elf <caller>
+extern void kernel_heap_trace_dump(int max_records);
+#endif
+
+#endif
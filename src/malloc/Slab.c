@@ -0,0 +1,188 @@
+#include "Slab.h"
+#include "Kernel.h"
+#include "Kheap.h"
+#include "Status.h"
+#include "memory/Memory.h"
+#include "vga/Vga.h"
+
+static void slab_list_remove(struct Slab** list, struct Slab* slab)
+{
+    if (slab->prev_)
+    {
+        slab->prev_->next_ = slab->next_;
+    }
+    else
+    {
+        *list = slab->next_;
+    }
+
+    if (slab->next_)
+    {
+        slab->next_->prev_ = slab->prev_;
+    }
+
+    slab->next_ = 0;
+    slab->prev_ = 0;
+}
+
+static void slab_list_push(struct Slab** list, struct Slab* slab)
+{
+    slab->prev_ = 0;
+    slab->next_ = *list;
+    if (*list)
+    {
+        (*list)->prev_ = slab;
+    }
+    *list = slab;
+}
+
+int slab_cache_init(struct SlabCache* cache, const char* name, size_t object_size, int slab_blocks,
+                    SLAB_CONSTRUCTOR_FUNCTION constructor)
+{
+    if (object_size < SLAB_MIN_OBJECT_SIZE || slab_blocks <= 0)
+    {
+        return -EINVARG;
+    }
+
+    memset(cache, 0, sizeof(struct SlabCache));
+    strncpy(cache->name, name, sizeof(cache->name));
+
+    // Keep objects 16 byte aligned, this also keeps every object off a heap block boundary.
+    cache->objectSize_ = (object_size + (SLAB_MIN_OBJECT_SIZE - 1)) & ~(SLAB_MIN_OBJECT_SIZE - 1);
+    cache->slabBlocks_ = slab_blocks;
+    cache->slotSize_ = cache->objectSize_;
+    cache->linkOffset_ = 0;
+    if (constructor)
+    {
+        cache->slotSize_ += SLAB_MIN_OBJECT_SIZE;
+        cache->linkOffset_ = cache->objectSize_;
+    }
+    cache->objectsPerSlab_ = ((slab_blocks * HEAP_BLOCK_SIZE) - SLAB_OBJECTS_OFFSET) / cache->slotSize_;
+    cache->constructor_ = constructor;
+
+    if (cache->objectsPerSlab_ <= 0)
+    {
+        return -EINVARG;
+    }
+
+    return 0;
+}
+
+// Free-list link of a free object, outside the object when a constructor owns its bytes.
+static void** slab_object_link(struct SlabCache* cache, void* object)
+{
+    return (void**)((char*)object + cache->linkOffset_);
+}
+
+static struct Slab* slab_create(struct SlabCache* cache)
+{
+    struct Slab* slab = kernel_page_alloc(cache->slabBlocks_ * HEAP_BLOCK_SIZE);
+    if (!slab)
+    {
+        return 0;
+    }
+
+    memset(slab, 0, sizeof(struct Slab));
+    slab->cache_ = cache;
+
+    // Chain the objects back to front so the free list hands them out in address order.
+    char* objects = (char*)slab + SLAB_OBJECTS_OFFSET;
+    for (int i = cache->objectsPerSlab_ - 1; i >= 0; i--)
+    {
+        void* object = objects + (i * cache->slotSize_);
+        if (cache->constructor_)
+        {
+            cache->constructor_(object);
+        }
+
+        *slab_object_link(cache, object) = slab->freeList_;
+        slab->freeList_ = object;
+    }
+
+    return slab;
+}
+
+void* slab_alloc(struct SlabCache* cache)
+{
+    struct Slab* slab = cache->partial_;
+    if (!slab)
+    {
+        slab = cache->empty_;
+        if (slab)
+        {
+            cache->empty_ = 0;
+        }
+        else
+        {
+            slab = slab_create(cache);
+            if (!slab)
+            {
+                return 0;
+            }
+        }
+
+        slab_list_push(&cache->partial_, slab);
+    }
+
+    void* object = slab->freeList_;
+    slab->freeList_ = *slab_object_link(cache, object);
+    slab->inUse_++;
+
+    if (!slab->freeList_)
+    {
+        slab_list_remove(&cache->partial_, slab);
+        slab_list_push(&cache->full_, slab);
+    }
+
+    return object;
+}
+
+void slab_free(void* object)
+{
+    struct Slab* slab = kernel_alloc_base(object);
+    if (!slab || slab->cache_ == 0)
+    {
+        log("Error: slab_free invalid pointer");
+        return;
+    }
+
+    struct SlabCache* cache = slab->cache_;
+    bool was_full = slab->freeList_ == 0;
+
+    *slab_object_link(cache, object) = slab->freeList_;
+    slab->freeList_ = object;
+    slab->inUse_--;
+
+    if (was_full)
+    {
+        slab_list_remove(&cache->full_, slab);
+        slab_list_push(&cache->partial_, slab);
+    }
+
+    if (slab->inUse_ > 0)
+    {
+        return;
+    }
+
+    slab_list_remove(&cache->partial_, slab);
+    if (!cache->empty_)
+    {
+        cache->empty_ = slab;
+        return;
+    }
+
+    // Already holding a spare, give the slab back to the heap.
+    slab->cache_ = 0;
+    kernel_free_alloc(slab);
+}
+
+size_t slab_object_size(void* object)
+{
+    struct Slab* slab = kernel_alloc_base(object);
+    if (!slab || slab->cache_ == 0)
+    {
+        return 0;
+    }
+
+    return slab->cache_->objectSize_;
+}
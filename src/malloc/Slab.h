@@ -0,0 +1,64 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "Memory_Constants.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+Slab Page (1 or more heap blocks) :
+                                        ............
+                                        . Slab     .  Header (cache, list links, free list)
+                                        ............  SLAB_OBJECTS_OFFSET
+                                        . Object 0 .
+                                        ............
+                                        . Object 1 .
+                                        ............
+                                        .  ......  .
+
+Free objects are chained through their first word. Caches with a constructor keep the link in
+16 bytes after each object instead, constructed contents survive on the free list. An object is
+never heap block aligned, so any block aligned pointer belongs to the block heap and any other
+pointer to a slab.
+*/
+
+// Objects start after the slab header, the header must fit in these bytes.
+#define SLAB_OBJECTS_OFFSET 32
+
+#define SLAB_MIN_OBJECT_SIZE 16
+
+typedef void (*SLAB_CONSTRUCTOR_FUNCTION)(void *object);
+
+struct Slab {
+    struct SlabCache *cache_;
+    struct Slab *next_;
+    struct Slab *prev_;
+    void *freeList_;
+    int inUse_;
+};
+
+struct SlabCache {
+    char name[20];
+    size_t objectSize_;
+    int slabBlocks_;     // Heap blocks per slab.
+    size_t slotSize_;    // Distance between objects, objectSize_ plus the free-list link when it's kept outside.
+    size_t linkOffset_;  // Offset of the free-list link in a free object's slot.
+    int objectsPerSlab_;
+    SLAB_CONSTRUCTOR_FUNCTION constructor_; // Runs once per object when its slab is created, freed objects must be
+                                            // returned in their constructed state.
+    struct Slab *partial_; // Slabs with at least one free object.
+    struct Slab *full_;
+    struct Slab *empty_;   // One spare empty slab, kept to avoid heap churn.
+};
+
+extern int slab_cache_init(struct SlabCache *cache, const char *name, size_t object_size, int slab_blocks,
+                           SLAB_CONSTRUCTOR_FUNCTION constructor);
+
+extern void *slab_alloc(struct SlabCache *cache);
+
+extern void slab_free(void *object);
+
+// Object size of the cache that object came from, 0 if it's not a slab object.
+extern size_t slab_object_size(void *object);
+
+#endif
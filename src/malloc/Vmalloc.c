@@ -0,0 +1,129 @@
+#include "Vmalloc.h"
+#include "Heap.h"
+#include "Kheap.h"
+#include "Status.h"
+#include "memory/Memory.h"
+#include "paging/Paging.h"
+#include "pmm/Pmm.h"
+#include "vga/Vga.h"
+
+// Address space of the window, one heap block per page.
+static struct Heap VMALLOC_SPACE_;
+static struct HeapMap VMALLOC_SPACE_MAP_;
+
+static struct PageDirectory* VMALLOC_DIRECTORY_ = 0;
+
+void vmalloc_init(struct PageDirectory* directory)
+{
+    size_t total_pages = VMALLOC_MAX_SIZE / PAGE_SIZE;
+
+    VMALLOC_DIRECTORY_ = directory;
+    VMALLOC_SPACE_MAP_.encoding_ = HEAP_MAP_ENCODING_BITMAP;
+    VMALLOC_SPACE_MAP_.totalEntries_ = total_pages;
+    VMALLOC_SPACE_MAP_.mapBaseAddress_ = kernel_page_alloc(heap_map_storage_size(HEAP_MAP_ENCODING_BITMAP, total_pages));
+    if (!VMALLOC_SPACE_MAP_.mapBaseAddress_)
+    {
+        panic("Error: vmalloc_init");
+    }
+
+    // Next fit keeps freed ranges unused for a while, stale pointers fault instead of hitting new data.
+    void* base = (void*)VMALLOC_VIRTUAL_ADDRESS_BASE;
+    if (heap_create(&VMALLOC_SPACE_, base, base + VMALLOC_MAX_SIZE, &VMALLOC_SPACE_MAP_, HEAP_POLICY_NEXT_FIT) < 0)
+    {
+        panic("Error: vmalloc_init");
+    }
+}
+
+int is_vmalloc_address(void* ptr)
+{
+    return (uint32_t)ptr >= VMALLOC_VIRTUAL_ADDRESS_BASE &&
+           (uint32_t)ptr - VMALLOC_VIRTUAL_ADDRESS_BASE < VMALLOC_MAX_SIZE;
+}
+
+void* vmalloc_to_physical(void* ptr)
+{
+    return paging_get_physical_address(paging_4gb_chunk_get_directory(VMALLOC_DIRECTORY_), ptr);
+}
+
+// Unmaps the pages of [ptr, ptr + total_pages), the window owns its frames and they go back to the PMM.
+static void vmalloc_release_pages(void* ptr, size_t total_pages)
+{
+    paging_unmap_range(VMALLOC_DIRECTORY_, ptr, total_pages);
+}
+
+void* vmalloc(size_t size)
+{
+    void* ptr = heap_malloc(&VMALLOC_SPACE_, size);
+    if (!ptr)
+    {
+        log("Error: vmalloc window exhausted");
+        return 0;
+    }
+
+    uint32_t* directory = paging_4gb_chunk_get_directory(VMALLOC_DIRECTORY_);
+    size_t total_pages = heap_allocation_size(&VMALLOC_SPACE_, ptr) / PAGE_SIZE;
+    for (size_t i = 0; i < total_pages; i++)
+    {
+        void* frame = pmm_alloc_frame();
+        if (!frame)
+        {
+            vmalloc_release_pages(ptr, i);
+            heap_free(&VMALLOC_SPACE_, ptr);
+            return 0;
+        }
+
+        // Frames are identity mapped in the kernel directory, zero them before they show up in the window.
+        memset(frame, 0x00, PAGE_SIZE);
+
+        void* page = ptr + i * PAGE_SIZE;
+        paging_set(directory, page,
+                   (uint32_t)frame | PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_IS_GLOBAL | PAGING_IS_OWNED);
+    }
+
+    return ptr;
+}
+
+void vfree(void* ptr)
+{
+    if (!ptr) return;
+
+    size_t size = heap_allocation_size(&VMALLOC_SPACE_, ptr);
+    if (!is_vmalloc_address(ptr) || size == 0)
+    {
+        log("Error: vfree invalid pointer");
+        return;
+    }
+
+    vmalloc_release_pages(ptr, size / PAGE_SIZE);
+    heap_free(&VMALLOC_SPACE_, ptr);
+}
+
+int vmalloc_map_to(struct PageDirectory* directory, void* virt, void* ptr, size_t size, int flags)
+{
+    int res = 0;
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE)
+    {
+        void* frame = vmalloc_to_physical(ptr + offset);
+        if (flags & PAGING_IS_OWNED)
+        {
+            // The mapping keeps the frame alive after vfree.
+            res = pmm_frame_ref(frame);
+            if (res < 0)
+            {
+                break;
+            }
+        }
+
+        res = map_virtual_address_to_physical_address(directory, virt + offset, frame, flags);
+        if (res < 0)
+        {
+            if (flags & PAGING_IS_OWNED)
+            {
+                pmm_free_frame(frame);
+            }
+            break;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,36 @@
+#ifndef VMALLOC_H
+#define VMALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct PageDirectory;
+
+/*
+Virtually contiguous kernel allocations for large buffers (ELF images, big directories).
+
+Pages come one by one from the PMM and are mapped into the vmalloc window of the kernel page directory, so they
+don't need a physically contiguous heap run. The window itself is handed out by a heap over
+VMALLOC_VIRTUAL_ADDRESS_BASE, its blocks are address ranges only and are never touched.
+
+The window's page tables are shared by every page directory, kernel only. Use vmalloc_map_to to give a task user
+access to the same frames.
+*/
+
+// directory is the kernel page directory, runs once it's allocated.
+extern void vmalloc_init(struct PageDirectory *directory);
+
+// Page granular and zeroed. 0 when the window or physical memory runs out.
+extern void *vmalloc(size_t size);
+
+extern void vfree(void *ptr);
+
+extern int is_vmalloc_address(void *ptr);
+
+extern void *vmalloc_to_physical(void *ptr);
+
+// Maps the frames behind [ptr, ptr + size) at virt in directory, ptr must be page aligned. With PAGING_IS_OWNED each
+// mapping takes a frame reference and the frames outlive vfree until the directory is freed.
+extern int vmalloc_map_to(struct PageDirectory *directory, void *virt, void *ptr, size_t size, int flags);
+
+#endif
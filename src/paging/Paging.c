@@ -1,74 +1,241 @@
 #include "Paging.h"
+#include "Config.h"
 #include "Status.h"
 #include "malloc/Kheap.h"
+#include "memory/Memory.h"
+#include "pmm/Pmm.h"
+#include "vga/Vga.h"
 
 void paging_load_directory(uint32_t* directory);
 
-static uint32_t* CURRENT_PAGE_DIRECTORY_ = 0;
+static struct PageDirectory* CURRENT_PAGE_DIRECTORY_ = 0;
+
+// Directory entry flags of page tables created on demand, the page entries decide the actual access.
+#define PAGING_TABLE_FLAGS (PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL)
+
+// 4MB covered by one page table.
+#define PAGING_TABLE_SPAN (TOTAL_PAGES_PER_TABLE * PAGE_SIZE)
+
+// Kernel only, supervisor pages in every address space.
+#define PAGING_KERNEL_FLAGS (PAGING_IS_PRESENT | PAGING_IS_WRITEABLE)
+
+// What it takes to drop a changed page entry from the TLB, the strongest one wins over a range.
+#define PAGING_TLB_CLEAN 0  // Nothing cached, the old entry wasn't present or its directory isn't loaded.
+#define PAGING_TLB_LOCAL 1  // Loaded directory, invlpg or a CR3 reload.
+#define PAGING_TLB_GLOBAL 2 // Global page or shared kernel table, any directory. invlpg or paging_flush_all.
 
 /*
-Enables 4GB virtual memory addressing. (32 bits memory addresses) 
-Allocates 4MB for page entries.
+Kernel half of every address space, built once by paging_kernel_directory_init :
 
-This function allocates memory for 4GB page directory that used to address accessibility. 
-No frame(4KB) allocation yet. No mapping v_address to p_address yet.
+RAM identity map  : 4MB pages (PSE) up to the probed end of RAM, directory entries only. The kernel touches the heap,
+                    PMM frames and its stack whatever directory is loaded. The first 4MB is a page table whose kernel
+                    image pages are global, they stay in the TLB across CR3 switches.
+vmalloc window    : page tables created up front and empty, vmalloc fills them in with global pages and every
+                    directory sees it.
+
+Every directory links these entries instead of copying the tables. A directory that maps a page of its own in one of
+these regions (user program, stack) gets a private table first, 4MB pages are split into 4KB ones.
 */
+static uint32_t PAGING_KERNEL_ENTRIES_[TOTAL_PAGES_PER_TABLE];
+static uint32_t* PAGING_KERNEL_DIRECTORY_ = 0;
 
-struct PageDirectory* new_page_directory_allocation(uint8_t flags)
+static bool paging_is_shared_entry(uint32_t* directory, uint32_t directory_index)
 {
-    // 1024 page tables
-    uint32_t* newPageDirectory = kernel_zeroed_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+    uint32_t entry = directory[directory_index];
+    return (entry & PAGING_IS_PRESENT) && entry == PAGING_KERNEL_ENTRIES_[directory_index];
+}
 
-    int offset_4_mb = 0;
+static bool paging_is_large_entry(uint32_t entry)
+{
+    return (entry & PAGING_IS_PRESENT) && (entry & PAGING_IS_LARGE_PAGE);
+}
 
-    // Allocate 1024 page tables
-    for (int page_table_idx = 0; page_table_idx < TOTAL_PAGES_PER_TABLE; page_table_idx++)
-    {
-        // Allocate 1024 pages
-        uint32_t* page_table_ptr = kernel_zeroed_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+// Page entry equivalent to the 4KB page at table_index of a 4MB page.
+static uint32_t paging_large_entry_page(uint32_t entry, uint32_t table_index)
+{
+    uint32_t flags = entry & ~MASK_12_BITS_PAGE & ~PAGING_IS_LARGE_PAGE;
+    return ((entry & MASK_22_BITS_LARGE_PAGE) + table_index * PAGE_SIZE) | flags;
+}
 
-        // Maps page table with 4MB(1024 * 4KB) physical address offsets. 
-        for (int page_idx = 0; page_idx < TOTAL_PAGES_PER_TABLE; page_idx++)
+// Page table behind a directory entry, created zeroed (nothing mapped) when create is set and there is none yet.
+// Writers outside the kernel directory get a private copy of a shared kernel table, a 4MB page is split into a table
+// of the same 4KB pages. Without create a 4MB page has no table.
+static uint32_t* paging_get_table(uint32_t* directory, uint32_t directory_index, bool create)
+{
+    uint32_t entry = directory[directory_index];
+    if (paging_is_large_entry(entry))
+    {
+        if (!create)
         {
-            // Page1 : 0 to 4 KB offset
-            // Page2 : 4 to 8 KB offset
-            // Page3 : 8 to 12 KB offset
-
-            // Map page with 4KB offset
-            page_table_ptr[page_idx] = (offset_4_mb + (page_idx * PAGE_SIZE)) | flags;
+            return 0;
         }
+    }
+    else if ((entry & PAGING_IS_PRESENT) && !(create && directory != PAGING_KERNEL_DIRECTORY_ &&
+                                              paging_is_shared_entry(directory, directory_index)))
+    {
+        return (uint32_t*)(entry & MASK_12_BITS_PAGE);
+    }
 
-        offset_4_mb += (TOTAL_PAGES_PER_TABLE * PAGE_SIZE); // move page table offset 4MB
+    if (!create)
+    {
+        return 0;
+    }
 
-        newPageDirectory[page_table_idx] = (uint32_t)page_table_ptr | flags | PAGING_IS_WRITEABLE;
+    uint32_t* table = kernel_zeroed_page_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+    if (!table)
+    {
+        return 0;
     }
 
-    // 1024 page tables (page directory)
-    // Each page table 1024 pages
-    // Each page 4KB offset
-    // 1024 * 1024 * 4096 = 4294967296 (4GB)
+    if (paging_is_large_entry(entry))
+    {
+        for (uint32_t i = 0; i < TOTAL_PAGES_PER_TABLE; i++)
+        {
+            table[i] = paging_large_entry_page(entry, i);
+        }
+    }
+    else if (entry & PAGING_IS_PRESENT)
+    {
+        memcpy(table, (void*)(entry & MASK_12_BITS_PAGE), sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+    }
 
-    // 4KB(4096) allocation each malloc
-    // 1024 iterations
-    // 1024 * 4096 = 4MB malloc memory allocation in total
+    directory[directory_index] = (uint32_t)table | PAGING_TABLE_FLAGS;
+    return table;
+}
 
+static struct PageDirectory* paging_directory_allocation()
+{
+    uint32_t* newPageDirectory = kernel_zeroed_page_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
     struct PageDirectory* chunk_4gb = kernel_zeroed_alloc(sizeof(struct PageDirectory));
+    if (!newPageDirectory || !chunk_4gb)
+    {
+        kernel_free_alloc(newPageDirectory);
+        kernel_free_alloc(chunk_4gb);
+        return 0;
+    }
+
     chunk_4gb->directory_entry_ptr = newPageDirectory;
     return chunk_4gb;
 }
 
+struct PageDirectory* paging_kernel_directory_init()
+{
+    struct PageDirectory* kernel_directory = paging_directory_allocation();
+    if (!kernel_directory)
+    {
+        panic("Error: paging_kernel_directory_init");
+    }
+
+    // The first 4MB holds the kernel image below the user stack. It keeps a 4KB page table so the kernel's pages can
+    // be global while the user stack pages, which every task maps to its own frames, are not.
+    uint32_t* directory = kernel_directory->directory_entry_ptr;
+    uint32_t* low_table = kernel_page_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+    if (!low_table)
+    {
+        panic("Error: paging_kernel_directory_init");
+    }
+
+    for (uint32_t i = 0; i < TOTAL_PAGES_PER_TABLE; i++)
+    {
+        uint32_t page = i * PAGE_SIZE;
+        uint32_t global = page < USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE ? PAGING_IS_GLOBAL : 0;
+        low_table[i] = page | PAGING_KERNEL_FLAGS | global;
+    }
+    directory[0] = (uint32_t)low_table | PAGING_KERNEL_FLAGS;
+
+    // The rest of RAM is identity mapped with 4MB pages, no page tables. Not global, tasks map their program images
+    // over it and process_malloc hands kernel heap pages to user space.
+    uint32_t identity_entries = (pmm_memory_end() + PAGING_TABLE_SPAN - 1) / PAGING_TABLE_SPAN;
+    for (uint32_t i = 1; i < identity_entries; i++)
+    {
+        directory[i] = (i * PAGING_TABLE_SPAN) | PAGING_KERNEL_FLAGS | PAGING_IS_LARGE_PAGE;
+    }
+
+    uint32_t vmalloc_first = VMALLOC_VIRTUAL_ADDRESS_BASE / PAGING_TABLE_SPAN;
+    for (uint32_t i = vmalloc_first; i < vmalloc_first + VMALLOC_MAX_SIZE / PAGING_TABLE_SPAN; i++)
+    {
+        uint32_t* page_table_ptr = kernel_zeroed_page_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+        if (!page_table_ptr)
+        {
+            panic("Error: paging_kernel_directory_init");
+        }
+
+        directory[i] = (uint32_t)page_table_ptr | PAGING_KERNEL_FLAGS;
+    }
+
+    memcpy(PAGING_KERNEL_ENTRIES_, directory, sizeof(PAGING_KERNEL_ENTRIES_));
+    PAGING_KERNEL_DIRECTORY_ = directory;
+    return kernel_directory;
+}
+
+/*
+Allocates a page directory that shares the kernel page tables, nothing else is mapped.
+
+Every other page table is created by paging_set the first time its 4MB region gets a mapping, a task only pays for
+the directory and the regions it maps.
+*/
+
+struct PageDirectory* new_page_directory_allocation()
+{
+    struct PageDirectory* chunk_4gb = paging_directory_allocation();
+    if (!chunk_4gb)
+    {
+        return 0;
+    }
+
+    memcpy(chunk_4gb->directory_entry_ptr, PAGING_KERNEL_ENTRIES_, sizeof(PAGING_KERNEL_ENTRIES_));
+    return chunk_4gb;
+}
+
 void set_current_page_directory(struct PageDirectory* directory)
 {
+    // Reloading CR3 flushes the whole TLB, skip it when the directory is already loaded.
+    if (directory == CURRENT_PAGE_DIRECTORY_)
+    {
+        return;
+    }
+
     paging_load_directory(directory->directory_entry_ptr);
-    CURRENT_PAGE_DIRECTORY_ = directory->directory_entry_ptr;
+    CURRENT_PAGE_DIRECTORY_ = directory;
+}
+
+struct PageDirectory* paging_current_directory()
+{
+    return CURRENT_PAGE_DIRECTORY_;
+}
+
+// Table the directory owns, not a 4MB page or a shared kernel table.
+static uint32_t* paging_private_table(uint32_t* directory, uint32_t directory_index)
+{
+    uint32_t entry = directory[directory_index];
+    if (!(entry & PAGING_IS_PRESENT) || paging_is_large_entry(entry) || paging_is_shared_entry(directory, directory_index))
+    {
+        return 0;
+    }
+
+    return (uint32_t*)(entry & MASK_12_BITS_PAGE);
 }
 
 void paging_free_4gb(struct PageDirectory* chunk)
 {
-    for (int i = 0; i < 1024; i++)
+    for (int i = 0; i < TOTAL_PAGES_PER_TABLE; i++)
     {
-        uint32_t entry = chunk->directory_entry_ptr[i];
-        uint32_t* table = (uint32_t*)(entry & MASK_12_BITS_PAGE);
+        // Shared kernel tables stay, they belong to every directory. 4MB pages have no table.
+        uint32_t* table = paging_private_table(chunk->directory_entry_ptr, i);
+        if (!table)
+        {
+            continue;
+        }
+
+        // Owned pages hold a reference to their frame.
+        for (int j = 0; j < TOTAL_PAGES_PER_TABLE; j++)
+        {
+            if ((table[j] & PAGING_IS_PRESENT) && (table[j] & PAGING_IS_OWNED))
+            {
+                pmm_free_frame((void*)(table[j] & MASK_12_BITS_PAGE));
+            }
+        }
+
         kernel_free_alloc(table);
     }
 
@@ -76,6 +243,105 @@ void paging_free_4gb(struct PageDirectory* chunk)
     kernel_free_alloc(chunk);
 }
 
+// One page of a forked directory: owned frames are shared, writable ones turn copy-on-write in both directories
+// unless they are shared memory.
+// User pages without an owner are identity mapped kernel heap (process_malloc), the copy keeps them kernel only so
+// the kernel still sees its heap there. 0 when a reference can't be taken.
+static uint32_t paging_share_page(uint32_t* page)
+{
+    uint32_t entry = *page;
+    if (!(entry & PAGING_IS_PRESENT))
+    {
+        return entry;
+    }
+
+    if (entry & PAGING_IS_OWNED)
+    {
+        if (pmm_frame_ref((void*)(entry & MASK_12_BITS_PAGE)) < 0)
+        {
+            return 0;
+        }
+
+        if ((entry & PAGING_IS_WRITEABLE) && !(entry & PAGING_IS_SHARED))
+        {
+            entry = (entry & ~PAGING_IS_WRITEABLE) | PAGING_IS_COW;
+            *page = entry;
+        }
+        return entry;
+    }
+
+    return entry & ~PAGING_ACCESS_FROM_ALL;
+}
+
+int paging_copy_user_mappings(struct PageDirectory* from, struct PageDirectory* to)
+{
+    int res = 0;
+    uint32_t* directory = from->directory_entry_ptr;
+    for (uint32_t i = 0; i < TOTAL_PAGES_PER_TABLE && res == 0; i++)
+    {
+        uint32_t* table = paging_private_table(directory, i);
+        if (!table)
+        {
+            continue;
+        }
+
+        uint32_t* copy = kernel_zeroed_page_alloc(sizeof(uint32_t) * TOTAL_PAGES_PER_TABLE);
+        if (!copy)
+        {
+            res = -ENOMEM;
+            break;
+        }
+
+        to->directory_entry_ptr[i] = (uint32_t)copy | PAGING_TABLE_FLAGS;
+        for (int j = 0; j < TOTAL_PAGES_PER_TABLE; j++)
+        {
+            copy[j] = paging_share_page(&table[j]);
+            if ((table[j] & PAGING_IS_PRESENT) && !copy[j])
+            {
+                // The rest stays unmapped, paging_free_4gb only drops what was shared.
+                res = -ENOMEM;
+                break;
+            }
+        }
+    }
+
+    // Writable pages of the source lost their write access.
+    if (CURRENT_PAGE_DIRECTORY_ == from)
+    {
+        paging_load_directory(directory);
+    }
+
+    return res;
+}
+
+int paging_resolve_cow(struct PageDirectory* directory, void* virt)
+{
+    void* page = paging_align_to_lower_page(virt);
+    uint32_t entry = paging_get(directory->directory_entry_ptr, page);
+    if (!(entry & PAGING_IS_PRESENT) || !(entry & PAGING_IS_COW))
+    {
+        return -EFAULT;
+    }
+
+    // The last sharer takes the frame back as is.
+    void* frame = (void*)(entry & MASK_12_BITS_PAGE);
+    if (pmm_frame_refcount(frame) > 1)
+    {
+        void* copy = pmm_alloc_frame();
+        if (!copy)
+        {
+            return -ENOMEM;
+        }
+
+        memcpy(copy, frame, PAGE_SIZE);
+        pmm_free_frame(frame);
+        frame = copy;
+    }
+
+    uint32_t flags = (entry & ~MASK_12_BITS_PAGE & ~PAGING_IS_COW) | PAGING_IS_WRITEABLE;
+    return paging_set(directory->directory_entry_ptr, page, (uint32_t)frame | flags);
+}
+
 uint32_t* paging_4gb_chunk_get_directory(struct PageDirectory* chunk)
 {
     return chunk->directory_entry_ptr;
@@ -119,6 +385,174 @@ void* paging_align_to_lower_page(void* addr)
     return (void*)_addr;
 }
 
+// Drops the translations of count pages from virt. Past PAGING_INVALIDATE_MAX_PAGES one full flush is cheaper than
+// an invlpg per page, a CR3 reload when only the loaded directory changed.
+static void paging_invalidate_range(void* virt, int count, int tlb)
+{
+    if (tlb == PAGING_TLB_CLEAN)
+    {
+        return;
+    }
+
+    if (count > PAGING_INVALIDATE_MAX_PAGES)
+    {
+        if (tlb == PAGING_TLB_GLOBAL)
+        {
+            paging_flush_all();
+        }
+        else
+        {
+            paging_load_directory(CURRENT_PAGE_DIRECTORY_->directory_entry_ptr);
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        paging_invalidate_page(virt + i * PAGE_SIZE);
+    }
+}
+
+// What it takes to drop the old entries of one table from the TLB. old is every old entry of the range or'ed.
+static int paging_table_tlb_state(uint32_t* directory, uint32_t directory_index, uint32_t old_directory_entry,
+                                  uint32_t old)
+{
+    // Not present entries are never cached. A private table that replaced a 4MB page or a shared table was.
+    bool table_replaced =
+        (old_directory_entry & PAGING_IS_PRESENT) && directory[directory_index] != old_directory_entry;
+    if (!(old & PAGING_IS_PRESENT) && !table_replaced)
+    {
+        return PAGING_TLB_CLEAN;
+    }
+
+    if (((old | old_directory_entry) & PAGING_IS_GLOBAL) || paging_is_shared_entry(directory, directory_index))
+    {
+        return PAGING_TLB_GLOBAL;
+    }
+
+    if (CURRENT_PAGE_DIRECTORY_ && directory == CURRENT_PAGE_DIRECTORY_->directory_entry_ptr)
+    {
+        return PAGING_TLB_LOCAL;
+    }
+
+    return PAGING_TLB_CLEAN;
+}
+
+// How paging_update_range rewrites each page entry.
+#define PAGING_RANGE_MAP 0     // phys | flags, phys moves on a page per entry. Old owned frames keep their reference.
+#define PAGING_RANGE_UNMAP 1   // 0, owned frames lose the reference of their mapping.
+#define PAGING_RANGE_PROTECT 2 // Present entries keep their frame, flags replace PAGING_PROTECT_FLAGS.
+
+// Permission bits paging_protect_range changes.
+#define PAGING_PROTECT_FLAGS (PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL)
+
+/*
+Rewrites count page entries from virt one page table at a time. The directory entry of each 4MB region is looked at
+once, its table created, split from a 4MB page or cloned from a shared table when needed, then the entries of the
+range in that table are written in one loop. The TLB is invalidated once at the end with the strongest state any
+table needed.
+*/
+static int paging_update_range(uint32_t* directory, void* virt, uint32_t phys, int count, int flags, int op)
+{
+    int res = 0;
+    int tlb = PAGING_TLB_CLEAN;
+    int done = 0;
+    while (done < count)
+    {
+        uint32_t directory_index = 0;
+        uint32_t table_index = 0;
+        res = paging_get_indexes(virt + done * PAGE_SIZE, &directory_index, &table_index);
+        if (res < 0)
+        {
+            break;
+        }
+
+        int total = TOTAL_PAGES_PER_TABLE - table_index;
+        if (total > count - done)
+        {
+            total = count - done;
+        }
+
+        // Only a mapping needs a table where there is none, unless a 4MB page or a shared table covers the range.
+        uint32_t old_directory_entry = directory[directory_index];
+        bool create = (op == PAGING_RANGE_MAP && (phys | flags)) || paging_is_large_entry(old_directory_entry) ||
+                      (directory != PAGING_KERNEL_DIRECTORY_ && paging_is_shared_entry(directory, directory_index));
+        uint32_t* table = paging_get_table(directory, directory_index, create);
+        if (!table)
+        {
+            if (create)
+            {
+                res = -ENOMEM;
+                break;
+            }
+
+            done += total;
+            continue;
+        }
+
+        uint32_t old = 0;
+        uint32_t* entry = &table[table_index];
+        uint32_t* end = entry + total;
+        switch (op)
+        {
+            case PAGING_RANGE_MAP:
+                for (; entry < end; entry++, phys += PAGE_SIZE)
+                {
+                    old |= *entry;
+                    *entry = phys | flags;
+                }
+                break;
+
+            case PAGING_RANGE_UNMAP:
+                for (; entry < end; entry++)
+                {
+                    if ((*entry & PAGING_IS_PRESENT) && (*entry & PAGING_IS_OWNED))
+                    {
+                        pmm_free_frame((void*)(*entry & MASK_12_BITS_PAGE));
+                    }
+                    old |= *entry;
+                    *entry = 0;
+                }
+                break;
+
+            case PAGING_RANGE_PROTECT:
+                for (; entry < end; entry++)
+                {
+                    if (!(*entry & PAGING_IS_PRESENT))
+                    {
+                        continue;
+                    }
+
+                    // Copy-on-write pages get write access back from paging_resolve_cow only.
+                    uint32_t permissions = flags & PAGING_PROTECT_FLAGS;
+                    if (*entry & PAGING_IS_COW)
+                    {
+                        permissions &= ~PAGING_IS_WRITEABLE;
+                    }
+                    old |= *entry;
+                    *entry = (*entry & ~PAGING_PROTECT_FLAGS) | permissions;
+                }
+                break;
+        }
+
+        int state = paging_table_tlb_state(directory, directory_index, old_directory_entry, old);
+        if (state > tlb)
+        {
+            tlb = state;
+        }
+        done += total;
+    }
+
+    paging_invalidate_range(virt, done, tlb);
+    return res;
+}
+
+int paging_set(uint32_t* directory, void* virt, uint32_t val)
+{
+    return paging_update_range(directory, virt, val & MASK_12_BITS_PAGE, 1, val & ~MASK_12_BITS_PAGE,
+                               PAGING_RANGE_MAP);
+}
+
 int map_virtual_address_to_physical_address(struct PageDirectory* directory, void* virt, void* phys, int flags)
 {
     if (((unsigned int)virt % PAGE_SIZE) || ((unsigned int)phys % PAGE_SIZE))
@@ -131,16 +565,22 @@ int map_virtual_address_to_physical_address(struct PageDirectory* directory, voi
 
 int paging_map_range(struct PageDirectory* directory, void* virt, void* phys, int count, int flags)
 {
-    int res = 0;
-    for (int i = 0; i < count; i++)
+    if ((uint32_t)phys % PAGE_SIZE)
     {
-        res = map_virtual_address_to_physical_address(directory, virt, phys, flags);
-        if (res < 0) break;
-        virt += PAGE_SIZE;
-        phys += PAGE_SIZE;
+        return -EINVARG;
     }
 
-    return res;
+    return paging_update_range(directory->directory_entry_ptr, virt, (uint32_t)phys, count, flags, PAGING_RANGE_MAP);
+}
+
+int paging_unmap_range(struct PageDirectory* directory, void* virt, int count)
+{
+    return paging_update_range(directory->directory_entry_ptr, virt, 0, count, 0, PAGING_RANGE_UNMAP);
+}
+
+int paging_protect_range(struct PageDirectory* directory, void* virt, int count, int flags)
+{
+    return paging_update_range(directory->directory_entry_ptr, virt, 0, count, flags, PAGING_RANGE_PROTECT);
 }
 
 int paging_map_to(struct PageDirectory* directory, void* virt, void* phys, void* phys_end, int flags)
@@ -175,28 +615,6 @@ out:
     return res;
 }
 
-int paging_set(uint32_t* directory, void* virt, uint32_t val)
-{
-    if (!paging_is_aligned(virt))
-    {
-        return -EINVARG;
-    }
-
-    uint32_t directory_index = 0;
-    uint32_t table_index = 0;
-    int res = paging_get_indexes(virt, &directory_index, &table_index);
-    if (res < 0)
-    {
-        return res;
-    }
-
-    uint32_t entry = directory[directory_index];
-    uint32_t* table = (uint32_t*)(entry & MASK_12_BITS_PAGE);
-    table[table_index] = val;
-
-    return 0;
-}
-
 void* paging_get_physical_address(uint32_t* directory, void* virt)
 {
     void* virt_addr_new = (void*)paging_align_to_lower_page(virt);
@@ -211,6 +629,16 @@ uint32_t paging_get(uint32_t* directory, void* virt)
     paging_get_indexes(virt, &directory_index, &table_index);
 
     uint32_t entry = directory[directory_index];
-    uint32_t* table = (uint32_t*)(entry & MASK_12_BITS_PAGE);
+    if (paging_is_large_entry(entry))
+    {
+        return paging_large_entry_page(entry, table_index);
+    }
+
+    uint32_t* table = paging_get_table(directory, directory_index, false);
+    if (!table)
+    {
+        return 0;
+    }
+
     return table[table_index];
 }
\ No newline at end of file
@@ -14,17 +14,30 @@
 #include <stdbool.h>
 #include "Memory_Constants.h"
 
+#define PAGING_IS_SHARED       0b100000000000 ///< Available bit, owned frame that forks share writable (shared memory).
+#define PAGING_IS_COW          0b10000000000 ///< Available bit, write protected frame shared with a fork.
+#define PAGING_IS_OWNED        0b1000000000 ///< Available bit, the mapping holds a PMM reference to its frame.
+#define PAGING_IS_GLOBAL       0b100000000 ///< Translation survives CR3 reloads (PGE), same mapping in every directory.
+#define PAGING_IS_LARGE_PAGE   0b10000000 ///< Directory entry maps a 4MB page itself (PSE), no page table.
 #define PAGING_CACHE_DISABLED  0b00010000 ///< Disable caching for this page.
 #define PAGING_WRITE_THROUGH   0b00001000 ///< Enable write-through caching.
 #define PAGING_ACCESS_FROM_ALL 0b00000100 ///< Allow access from all privilege levels.
 #define PAGING_IS_WRITEABLE    0b00000010 ///< Page is writable.
 #define PAGING_IS_PRESENT      0b00000001 ///< Page is present in memory.
 
+// Page fault error code bits, pushed by the CPU with #PF.
+#define PAGING_FAULT_PRESENT 0b001 ///< The page was present, the access broke its protection.
+#define PAGING_FAULT_WRITE   0b010 ///< The access was a write.
+#define PAGING_FAULT_USER    0b100 ///< The access came from ring 3.
+
 // Mask the lower 12 bits of a 32-bit address as offset. 
 // These lower 12 bits are used for the offset within a page. 
 // Using this mask with a bitwise AND operation (&) clears the lower 12 bits of an address.
 #define MASK_12_BITS_PAGE 0xFFFFF000    // 11111111111111111111000000000000
 
+// Physical base of a 4MB page in a directory entry, the lower 22 bits are flags and offset.
+#define MASK_22_BITS_LARGE_PAGE 0xFFC00000
+
 /**
  * @struct PageDirectory
  * @brief Structure representing a 4GB chunk of memory managed by paging.
@@ -36,33 +49,99 @@ struct PageDirectory {
     uint32_t *directory_entry_ptr; ///< Pointer to the directory entries.
 };
 
+/**
+ * @brief Builds the kernel page tables shared by every address space and returns the kernel's own directory.
+ *
+ * Maps RAM 1:1 with 4MB pages and reserves the vmalloc window, kernel only. Runs once, before any other directory
+ * is allocated.
+ *
+ * @return struct PageDirectory* The kernel page directory.
+ */
+extern struct PageDirectory *paging_kernel_directory_init();
+
 /**
  * @brief Allocates page directory for 4GB address mapping.
  *
- * @param flags Flags to apply to each page in this chunk.
- * @return struct PageDirectory* Pointer to the new 4GB chunk.
+ * Links the shared kernel page tables, page tables for any other region are created by paging_set on first use.
+ *
+ * @return struct PageDirectory* Pointer to the new 4GB chunk, 0 when the kernel heap is exhausted.
+ */
+extern struct PageDirectory *new_page_directory_allocation();
+
+/**
+ * @brief Gives a fresh directory the user mappings of another one, for fork.
+ *
+ * Private page tables are copied. Owned frames are shared with one more reference each and writable ones become
+ * copy-on-write in both directories unless they are PAGING_IS_SHARED, user pages without an owner (process_malloc
+ * memory) turn kernel only.
+ *
+ * @param from Directory to copy, usually the loaded one.
+ * @param to Directory from new_page_directory_allocation.
+ * @return int 0 on success, -ENOMEM, to is then only partly filled and must be freed with paging_free_4gb.
  */
-extern struct PageDirectory *new_page_directory_allocation(uint8_t flags);
+extern int paging_copy_user_mappings(struct PageDirectory *from, struct PageDirectory *to);
+
+/**
+ * @brief Handles a write to a copy-on-write page, the frame is copied unless no one else shares it anymore.
+ *
+ * @param directory Directory of the faulting task.
+ * @param virt Faulting virtual address.
+ * @return int 0 when the page is writable again, -EFAULT when it isn't copy-on-write, -ENOMEM.
+ */
+extern int paging_resolve_cow(struct PageDirectory *directory, void *virt);
 
 /**
  * @brief Switches the current page directory to the one specified by the 4GB chunk.
  *
+ * Does nothing when the directory is already loaded, so the TLB is not flushed. paging_set invalidates the pages it
+ * changes in the loaded directory and in the shared kernel tables.
+ *
  * @param directory Pointer to the paging chunk whose directory to switch to.
  */
 extern void set_current_page_directory(struct PageDirectory *directory);
 
 /**
- * @brief Enables paging on the system.
+ * @brief Returns the page directory currently loaded in CR3.
+ *
+ * @return struct PageDirectory* The loaded directory, 0 before the first set_current_page_directory.
+ */
+extern struct PageDirectory *paging_current_directory();
+
+/**
+ * @brief Enables paging on the system, with 4MB page support (CR4.PSE) for the kernel identity map and global
+ * pages (CR4.PGE) for the kernel.
  */
 extern void enable_paging();
 
 /**
- * @brief Sets a page in the directory.
+ * @brief Flushes the whole TLB, global pages included, by toggling CR4.PGE.
+ *
+ * A CR3 reload keeps global pages, use this after changing many global (shared kernel) mappings at once.
+ */
+extern void paging_flush_all();
+
+/**
+ * @brief Returns the address whose access raised the last page fault (CR2).
+ */
+extern void *paging_fault_address();
+
+/**
+ * @brief Drops the TLB entry of one page after its mapping changed in the loaded directory.
+ *
+ * @param virt Virtual address within the page.
+ */
+extern void paging_invalidate_page(void *virt);
+
+/**
+ * @brief Sets a page in the directory, allocating the page table of its 4MB region if needed.
+ *
+ * Invalidates the old translation when the CPU may have cached it, the directory is loaded or the page is a shared
+ * kernel one.
  *
  * @param directory Pointer to the page directory.
  * @param virt Virtual address to map.
  * @param val Value to set in the page directory entry.
- * @return int Success or failure of the operation.
+ * @return int Success or failure of the operation, -ENOMEM when no page table could be allocated.
  */
 extern int paging_set(uint32_t *directory, void *virt, uint32_t val);
 
@@ -83,7 +162,7 @@ extern bool paging_is_aligned(void *addr);
 extern uint32_t *paging_4gb_chunk_get_directory(struct PageDirectory *chunk);
 
 /**
- * @brief Frees a 4GB chunk of memory.
+ * @brief Frees a 4GB chunk of memory, the shared kernel page tables are left alone.
  *
  * @param chunk Pointer to the 4GB chunk to free.
  */
@@ -104,6 +183,9 @@ extern int paging_map_to(struct PageDirectory *directory, void *virt, void *phys
 /**
  * @brief Maps a range of physical addresses to virtual addresses.
  *
+ * Each page table is looked up once and its entries of the range are written in one loop. Invalidates like
+ * paging_set, but once for the range. Past PAGING_INVALIDATE_MAX_PAGES it flushes the whole TLB.
+ *
  * @param directory Pointer to the 4GB chunk directory.
  * @param virt Virtual address start.
  * @param phys Physical address start.
@@ -113,6 +195,31 @@ extern int paging_map_to(struct PageDirectory *directory, void *virt, void *phys
  */
 extern int paging_map_range(struct PageDirectory *directory, void *virt, void *phys, int count, int flags);
 
+/**
+ * @brief Unmaps a range of pages, owned pages (PAGING_IS_OWNED) drop their frame reference.
+ *
+ * Regions without a page table are skipped, 4MB pages and shared kernel tables get a private table first.
+ *
+ * @param directory Pointer to the 4GB chunk directory.
+ * @param virt Virtual address start, page aligned.
+ * @param count Number of pages to unmap.
+ * @return int Success or failure of the operation.
+ */
+extern int paging_unmap_range(struct PageDirectory *directory, void *virt, int count);
+
+/**
+ * @brief Changes the permissions of the present pages of a range, frames and other flags stay.
+ *
+ * Copy-on-write pages stay read only, the next write copies them as before.
+ *
+ * @param directory Pointer to the 4GB chunk directory.
+ * @param virt Virtual address start, page aligned.
+ * @param count Number of pages to change.
+ * @param flags New PAGING_IS_WRITEABLE and PAGING_ACCESS_FROM_ALL bits, others are ignored.
+ * @return int Success or failure of the operation.
+ */
+extern int paging_protect_range(struct PageDirectory *directory, void *virt, int count, int flags);
+
 /**
  * @brief Maps a single physical address to a virtual address.
  *
@@ -137,7 +244,7 @@ extern void *paging_align_address(void *ptr);
  *
  * @param directory Pointer to the page directory.
  * @param virt Virtual address.
- * @return uint32_t Value of the page directory entry.
+ * @return uint32_t Value of the page directory entry, 0 when the region has no page table.
  */
 extern uint32_t paging_get(uint32_t *directory, void *virt);
 
@@ -0,0 +1,250 @@
+#include "Pmm.h"
+#include "Kernel.h"
+#include "Status.h"
+#include "memory/Memory.h"
+#include "vga/Vga.h"
+#include <stdbool.h>
+
+#define PMM_WORD_BITS 32
+#define PMM_FULL_WORD 0xFFFFFFFF
+
+struct Pmm {
+    uint32_t *bitmap_;      // Set bit = frame in use.
+    uint8_t *refcounts_;    // Mappings sharing each used frame, 1 when it has a single owner.
+    size_t totalFrames_;    // Frames from PMM_BASE_ADDRESS to memoryEnd_.
+    size_t freeFrames_;
+    size_t nextFreeWord_;   // No free frame below this word, single frame allocations start here.
+    uint32_t memoryEnd_;
+};
+
+static struct Pmm PMM_;
+
+static void *pmm_frame_to_address(size_t frame)
+{
+    return (void *)(PMM_BASE_ADDRESS + frame * PMM_FRAME_SIZE);
+}
+
+static size_t pmm_address_to_frame(void *address)
+{
+    return ((uint32_t)address - PMM_BASE_ADDRESS) / PMM_FRAME_SIZE;
+}
+
+static bool pmm_frame_is_used(size_t frame)
+{
+    return (PMM_.bitmap_[frame / PMM_WORD_BITS] >> (frame % PMM_WORD_BITS)) & 1;
+}
+
+static void pmm_mark_frames(size_t frame, size_t total_frames, bool used)
+{
+    for (size_t i = frame; i < frame + total_frames; i++)
+    {
+        uint32_t bit = 1U << (i % PMM_WORD_BITS);
+        if (used)
+        {
+            PMM_.bitmap_[i / PMM_WORD_BITS] |= bit;
+        }
+        else
+        {
+            PMM_.bitmap_[i / PMM_WORD_BITS] &= ~bit;
+        }
+        PMM_.refcounts_[i] = used;
+    }
+
+    if (used)
+    {
+        PMM_.freeFrames_ -= total_frames;
+    }
+    else
+    {
+        PMM_.freeFrames_ += total_frames;
+        if (frame / PMM_WORD_BITS < PMM_.nextFreeWord_)
+        {
+            PMM_.nextFreeWord_ = frame / PMM_WORD_BITS;
+        }
+    }
+}
+
+void pmm_init(uint32_t memory_end)
+{
+    if (memory_end > PMM_MAX_MEMORY_END)
+    {
+        memory_end = PMM_MAX_MEMORY_END;
+    }
+
+    if (memory_end <= PMM_BASE_ADDRESS)
+    {
+        panic("Error: pmm_init no memory above PMM_BASE_ADDRESS");
+    }
+
+    memset(&PMM_, 0, sizeof(PMM_));
+    PMM_.memoryEnd_ = memory_end;
+    PMM_.totalFrames_ = (memory_end - PMM_BASE_ADDRESS) / PMM_FRAME_SIZE;
+
+    size_t total_words = (PMM_.totalFrames_ + PMM_WORD_BITS - 1) / PMM_WORD_BITS;
+    size_t bitmap_frames = (total_words * sizeof(uint32_t) + PMM_FRAME_SIZE - 1) / PMM_FRAME_SIZE;
+    size_t refcount_frames = (PMM_.totalFrames_ + PMM_FRAME_SIZE - 1) / PMM_FRAME_SIZE;
+
+    // The bitmap takes the first managed frames, the reference counts the ones after it.
+    PMM_.bitmap_ = (uint32_t *)PMM_BASE_ADDRESS;
+    memset(PMM_.bitmap_, 0, total_words * sizeof(uint32_t));
+    PMM_.refcounts_ = (uint8_t *)pmm_frame_to_address(bitmap_frames);
+    memset(PMM_.refcounts_, 0, PMM_.totalFrames_);
+
+    // Padding bits past the last frame stay used so scans never hand them out.
+    for (size_t i = PMM_.totalFrames_; i < total_words * PMM_WORD_BITS; i++)
+    {
+        PMM_.bitmap_[i / PMM_WORD_BITS] |= 1U << (i % PMM_WORD_BITS);
+    }
+
+    PMM_.freeFrames_ = PMM_.totalFrames_;
+    pmm_mark_frames(0, bitmap_frames + refcount_frames, true);
+
+    logAddress("pmm memory end: ", memory_end);
+    logAddress("pmm free frames: ", PMM_.freeFrames_);
+}
+
+void *pmm_alloc_frame()
+{
+    size_t total_words = (PMM_.totalFrames_ + PMM_WORD_BITS - 1) / PMM_WORD_BITS;
+
+    for (size_t word = PMM_.nextFreeWord_; word < total_words; word++)
+    {
+        if (PMM_.bitmap_[word] == PMM_FULL_WORD)
+        {
+            continue;
+        }
+
+        PMM_.nextFreeWord_ = word;
+        size_t frame = word * PMM_WORD_BITS + __builtin_ctz(~PMM_.bitmap_[word]);
+        pmm_mark_frames(frame, 1, true);
+        return pmm_frame_to_address(frame);
+    }
+
+    PMM_.nextFreeWord_ = total_words;
+    log("Error: pmm_alloc_frame out of memory");
+    return 0;
+}
+
+void *pmm_alloc_frames(size_t total_frames)
+{
+    if (total_frames == 0)
+    {
+        return 0;
+    }
+
+    if (total_frames == 1)
+    {
+        return pmm_alloc_frame();
+    }
+
+    size_t run = 0;
+    for (size_t frame = PMM_.nextFreeWord_ * PMM_WORD_BITS; frame < PMM_.totalFrames_; frame++)
+    {
+        // Whole used words can't contain the start of a run.
+        if (run == 0 && frame % PMM_WORD_BITS == 0 && PMM_.bitmap_[frame / PMM_WORD_BITS] == PMM_FULL_WORD)
+        {
+            frame += PMM_WORD_BITS - 1;
+            continue;
+        }
+
+        if (pmm_frame_is_used(frame))
+        {
+            run = 0;
+            continue;
+        }
+
+        run++;
+        if (run == total_frames)
+        {
+            size_t start = frame + 1 - total_frames;
+            pmm_mark_frames(start, total_frames, true);
+            return pmm_frame_to_address(start);
+        }
+    }
+
+    log("Error: pmm_alloc_frames out of memory");
+    return 0;
+}
+
+void pmm_free_frames(void *frame, size_t total_frames)
+{
+    if ((uint32_t)frame < PMM_BASE_ADDRESS || (uint32_t)frame % PMM_FRAME_SIZE)
+    {
+        log("Error: pmm_free_frames invalid frame");
+        return;
+    }
+
+    size_t first = pmm_address_to_frame(frame);
+    if (first + total_frames > PMM_.totalFrames_)
+    {
+        log("Error: pmm_free_frames invalid frame");
+        return;
+    }
+
+    for (size_t i = first; i < first + total_frames; i++)
+    {
+        if (!pmm_frame_is_used(i))
+        {
+            log("Error: pmm_free_frames double free");
+            return;
+        }
+    }
+
+    pmm_mark_frames(first, total_frames, false);
+}
+
+// Frames below PMM_BASE_ADDRESS or past the end of RAM have no reference count.
+static bool pmm_is_managed(void *frame)
+{
+    return (uint32_t)frame >= PMM_BASE_ADDRESS && pmm_address_to_frame(frame) < PMM_.totalFrames_;
+}
+
+void pmm_free_frame(void *frame)
+{
+    if (pmm_is_managed(frame) && PMM_.refcounts_[pmm_address_to_frame(frame)] > 1)
+    {
+        PMM_.refcounts_[pmm_address_to_frame(frame)]--;
+        return;
+    }
+
+    pmm_free_frames(frame, 1);
+}
+
+int pmm_frame_ref(void *frame)
+{
+    if (!pmm_is_managed(frame) || !pmm_frame_is_used(pmm_address_to_frame(frame)))
+    {
+        log("Error: pmm_frame_ref invalid frame");
+        return -EINVARG;
+    }
+
+    uint8_t *refcount = &PMM_.refcounts_[pmm_address_to_frame(frame)];
+    if (*refcount == PMM_MAX_FRAME_REFS)
+    {
+        log("Error: pmm_frame_ref too many references");
+        return -ENOMEM;
+    }
+
+    (*refcount)++;
+    return 0;
+}
+
+int pmm_frame_refcount(void *frame)
+{
+    if (!pmm_is_managed(frame))
+    {
+        return 0;
+    }
+
+    return PMM_.refcounts_[pmm_address_to_frame(frame)];
+}
+
+size_t pmm_free_frame_count()
+{
+    return PMM_.freeFrames_;
+}
+
+uint32_t pmm_memory_end()
+{
+    return PMM_.memoryEnd_;
+}
@@ -0,0 +1,37 @@
+#ifndef PMM_H
+#define PMM_H
+
+#include "Memory_Constants.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Physical frame allocator for RAM between PMM_BASE_ADDRESS and the probed end of memory.
+// One bit per 4KB frame, the bitmap itself lives in the first frames it manages.
+// Single frames can be shared (copy-on-write, fork), each one counts its references in a byte after the bitmap.
+
+#define PMM_MAX_FRAME_REFS 255
+
+extern void pmm_init(uint32_t memory_end);
+
+// Single frame, 0 when physical memory is exhausted.
+extern void *pmm_alloc_frame();
+
+// Physically contiguous run of frames, 0 when no run is long enough.
+extern void *pmm_alloc_frames(size_t total_frames);
+
+// Drops one reference, the frame is only freed with the last one.
+extern void pmm_free_frame(void *frame);
+
+// Adds a reference to a used frame, -ENOMEM past PMM_MAX_FRAME_REFS.
+extern int pmm_frame_ref(void *frame);
+
+// References of a used frame, 0 for free frames and memory the PMM doesn't manage.
+extern int pmm_frame_refcount(void *frame);
+
+extern void pmm_free_frames(void *frame, size_t total_frames);
+
+extern size_t pmm_free_frame_count();
+
+extern uint32_t pmm_memory_end();
+
+#endif
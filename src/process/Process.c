@@ -3,10 +3,14 @@
 #include "Process.h"
 #include "Status.h"
 #include "fs/File.h"
+#include "fs/PageCache.h"
 #include "loader/Elfloader.h"
 #include "memory/Memory.h"
 #include "malloc/Kheap.h"
+#include "malloc/Vmalloc.h"
 #include "paging/Paging.h"
+#include "pmm/Pmm.h"
+#include "process/Shm.h"
 #include "process/Task.h"
 #include "vga/Vga.h"
 
@@ -64,7 +68,7 @@ static int process_find_free_allocation_index(struct Process* process)
 // Allocates memory of the specified size for a process, and maps it to the process's page directory
 void* process_malloc(struct Process* process, size_t size)
 {
-    void* ptr = kernel_zeroed_alloc(size);
+    void* ptr = kernel_zeroed_page_alloc(size);
     if (!ptr)
     {
         goto out_err;
@@ -95,6 +99,14 @@ out_err:
     return 0;
 }
 
+// Heap allocations are identity mapped, freed ones go back to the kernel only mapping the kernel itself sees in
+// this directory during syscalls, unmapping them would fault the kernel once the heap reuses the memory.
+static void process_unmap_allocation(struct Process* process, void* ptr, size_t size)
+{
+    paging_protect_range(process->task->page_directory, ptr, (paging_align_address(ptr + size) - ptr) / PAGE_SIZE,
+                         PAGING_IS_WRITEABLE);
+}
+
 // Checks if the given pointer is part of the process's memory allocations
 static bool process_is_process_pointer(struct Process* process, void* ptr)
 {
@@ -141,10 +153,161 @@ int process_terminate_allocations(struct Process* process)
     return 0;
 }
 
+// Adds a demand paged region, [start, end) must be page aligned and its pages unmapped or owned by the region
+static struct ProcessRegion* process_add_region(struct Process* process, uint32_t start, uint32_t end, int flags,
+                                                uint8_t type)
+{
+    for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+    {
+        struct ProcessRegion* region = &process->regions[i];
+        if (region->start == 0)
+        {
+            region->start = start;
+            region->end = end;
+            region->flags = flags;
+            region->type = type;
+            return region;
+        }
+    }
+
+    return 0;
+}
+
+// Region that starts exactly at start, regions may be empty (the heap before the first sbrk)
+static struct ProcessRegion* process_get_region(struct Process* process, uint32_t start)
+{
+    for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+    {
+        if (process->regions[i].start && process->regions[i].start == start)
+        {
+            return &process->regions[i];
+        }
+    }
+
+    return 0;
+}
+
+// Drops the region's mapping of its shared memory segment or page cache file
+static void process_put_region_object(struct ProcessRegion* region)
+{
+    if (region->start && region->type == PROCESS_REGION_SHARED)
+    {
+        shm_put(region->object);
+    }
+    else if (region->start && region->type == PROCESS_REGION_FILE)
+    {
+        page_cache_put(region->object);
+    }
+}
+
+// Region that contains address
+static struct ProcessRegion* process_find_region(struct Process* process, uint32_t address)
+{
+    for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+    {
+        struct ProcessRegion* region = &process->regions[i];
+        if (region->start && address >= region->start && address < region->end)
+        {
+            return region;
+        }
+    }
+
+    return 0;
+}
+
+int process_handle_page_fault(struct Process* process, void* address, uint32_t error_code)
+{
+    // A write to a present page is fine only when the page is copy-on-write.
+    if (error_code & PAGING_FAULT_PRESENT)
+    {
+        if (!(error_code & PAGING_FAULT_WRITE))
+        {
+            return -EFAULT;
+        }
+
+        return paging_resolve_cow(process->task->page_directory, address);
+    }
+
+    uint32_t page = (uint32_t)paging_align_to_lower_page(address);
+    struct ProcessRegion* region = process_find_region(process, page);
+    if (!region || region->type == PROCESS_REGION_SHARED ||
+        ((error_code & PAGING_FAULT_WRITE) && !(region->flags & PAGING_IS_WRITEABLE)))
+    {
+        return -EFAULT;
+    }
+
+    // Mapped since the fault was raised.
+    uint32_t* directory = process->task->page_directory->directory_entry_ptr;
+    if (paging_get(directory, (void*)page) & PAGING_IS_PRESENT)
+    {
+        return 0;
+    }
+
+    // Either way the frame comes with the mapping's reference.
+    void* frame = 0;
+    if (region->type == PROCESS_REGION_FILE)
+    {
+        int res = page_cache_map_page(region->object, (page - region->start) / PAGE_SIZE, &frame);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+    else
+    {
+        frame = pmm_alloc_frame();
+        if (!frame)
+        {
+            return -ENOMEM;
+        }
+        memset(frame, 0x00, PAGE_SIZE);
+    }
+
+    int res = map_virtual_address_to_physical_address(process->task->page_directory, (void*)page, frame,
+                                                      region->flags | PAGING_IS_OWNED);
+    if (res < 0)
+    {
+        pmm_free_frame(frame);
+    }
+
+    return res;
+}
+
+// Only moves the break, the heap region hands out its frames on first touch
+void* process_sbrk(struct Process* process, int increment)
+{
+    uint32_t old_break = process->heapBreak;
+    uint32_t new_break = old_break + increment;
+
+    if (new_break < USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE ||
+        new_break > USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE + USER_PROCESS_HEAP_MAX_SIZE ||
+        (increment > 0 && new_break < old_break))
+    {
+        return 0;
+    }
+
+    struct ProcessRegion* heap = process_get_region(process, USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE);
+    if (!heap)
+    {
+        return 0;
+    }
+
+    uint32_t old_end = heap->end;
+    uint32_t new_end = (uint32_t)paging_align_address((void*)new_break);
+    if (new_end < old_end)
+    {
+        paging_unmap_range(process->task->page_directory, (void*)new_end, (old_end - new_end) / PAGE_SIZE);
+    }
+
+    heap->end = new_end;
+    process->heapBreak = new_break;
+    return (void*)old_break;
+}
+
 // Frees the memory allocated for a process's binary data
 int process_free_binary_data(struct Process* process)
 {
-    kernel_free_alloc(process->processBaseAddr);
+    vfree(process->processBaseAddr);
     return 0;
 }
 
@@ -169,6 +332,10 @@ int process_free_program_data(struct Process* process)
             res = process_free_elf_data(process);
             break;
 
+        // The program data stays with the parent, the mapped pages hold their own frame references.
+        case PROCESS_FILETYPE_FORK:
+            break;
+
         default:
             res = -EINVARG;
     }
@@ -218,10 +385,14 @@ int process_terminate(struct Process* process)
         goto out;
     }
 
-    // Free the process stack memory.
-    kernel_free_alloc(process->stackPtr);
+    // Shared memory and mapped files count their mappings, the frames go with the directory like all others.
+    for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+    {
+        process_put_region_object(&process->regions[i]);
+    }
+    shm_release_creator(process->processId);
 
-    // Free the task
+    // Free the task, its directory drops the frame references of the program, stack, heap and bss pages.
     task_free(process->task);
     
     // Unlink the process from the process array.
@@ -252,12 +423,41 @@ int process_count_command_arguments(struct CommandArgument* root_argument)
     return i;
 }
 
-// Injects command-line arguments into a process
+// First fit range of size bytes in the mapping window, 0 when it is full
+static uint32_t process_find_map_range(struct Process* process, uint32_t size)
+{
+    uint32_t start = USER_PROCESS_MAP_VIRTUAL_ADDRESS_BASE;
+    uint32_t window_end = USER_PROCESS_MAP_VIRTUAL_ADDRESS_BASE + USER_PROCESS_MAP_MAX_SIZE;
+
+    // Every overlap moves start past a region, each pass only goes up.
+    bool moved = true;
+    while (moved)
+    {
+        moved = false;
+        if (size > window_end - start)
+        {
+            return 0;
+        }
+
+        for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+        {
+            struct ProcessRegion* region = &process->regions[i];
+            if (region->start && region->start < start + size && region->end > start)
+            {
+                start = region->end;
+                moved = true;
+            }
+        }
+    }
+
+    return start;
+}
+
+// Injects command-line arguments into a process, the argv array and its strings go to a region of the mapping
+// window so they are user frames a fork shares copy-on-write.
 int process_inject_arguments(struct Process* process, struct CommandArgument* root_argument)
 {
     int res = 0;
-    struct CommandArgument* current = root_argument;
-    int i = 0;
     int argc = process_count_command_arguments(root_argument);
     if (argc == 0)
     {
@@ -265,26 +465,46 @@ int process_inject_arguments(struct Process* process, struct CommandArgument* ro
         goto out;
     }
 
-    char** argv = process_malloc(process, sizeof(const char*) * argc);
-    if (!argv)
+    uint32_t size = sizeof(char*) * argc;
+    for (struct CommandArgument* current = root_argument; current; current = current->next)
+    {
+        size += strnlen(current->argument, sizeof(current->argument) - 1) + 1;
+    }
+
+    uint32_t region_size = (uint32_t)paging_align_address((void*)size);
+    uint32_t start = process_find_map_range(process, region_size);
+    if (!start || !process_add_region(process, start, start + region_size,
+                                      PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL,
+                                      PROCESS_REGION_ANONYMOUS))
     {
         res = -ENOMEM;
         goto out;
     }
 
-    while (current)
+    // The process may not be the loaded one, copy_to_user maps the region's frames on the way.
+    char** argv = (char**)start;
+    char* argument_str = (char*)(argv + argc);
+    int i = 0;
+    for (struct CommandArgument* current = root_argument; current; current = current->next, i++)
     {
-        char* argument_str = process_malloc(process, sizeof(current->argument));
-        if (!argument_str)
+        int len = strnlen(current->argument, sizeof(current->argument) - 1);
+        char terminator = 0;
+        res = copy_to_user(process->task, &argv[i], &argument_str, sizeof(argument_str));
+        if (res < 0)
         {
-            res = -ENOMEM;
             goto out;
         }
-
-        strncpy(argument_str, current->argument, sizeof(current->argument));
-        argv[i] = argument_str;
-        current = current->next;
-        i++;
+        res = copy_to_user(process->task, argument_str, current->argument, len);
+        if (res < 0)
+        {
+            goto out;
+        }
+        res = copy_to_user(process->task, argument_str + len, &terminator, sizeof(terminator));
+        if (res < 0)
+        {
+            goto out;
+        }
+        argument_str += len + 1;
     }
 
     process->processArguments.argc = argc;
@@ -304,12 +524,7 @@ void process_free(struct Process* process, void* ptr)
         return;
     }
 
-    int res = paging_map_to(process->task->page_directory, allocation->ptr, allocation->ptr,
-                            paging_align_address(allocation->ptr + allocation->size), 0x00);
-    if (res < 0)
-    {
-        return;
-    }
+    process_unmap_allocation(process, allocation->ptr, allocation->size);
 
     // Unjoin the allocation
     process_allocation_unjoin(process, ptr);
@@ -318,6 +533,82 @@ void process_free(struct Process* process, void* ptr)
     kernel_free_alloc(ptr);
 }
 
+// Resizes a memory allocation of a process and remaps it
+void* process_realloc(struct Process* process, void* ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return process_malloc(process, size);
+    }
+
+    struct ProcessAllocation* allocation = process_get_allocation_by_addr(process, ptr);
+    if (!allocation)
+    {
+        return 0;
+    }
+
+    if (size == 0)
+    {
+        process_free(process, ptr);
+        return 0;
+    }
+
+    int flags = PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL;
+    size_t old_size = allocation->size;
+    void* old_end = paging_align_address(ptr + old_size);
+
+    // Resize in place or move to a new run, the old mapping stays untouched until the new one is in place.
+    bool in_place = kernel_resize_page_alloc(ptr, size);
+    void* new_ptr = ptr;
+    size_t kept = old_size < size ? old_size : size;
+    if (!in_place)
+    {
+        new_ptr = kernel_page_alloc(size);
+        if (!new_ptr)
+        {
+            return 0;
+        }
+        memcpy(new_ptr, ptr, kept);
+    }
+
+    // Neither the heap nor a move clears the blocks, zero everything past the kept data the process will see.
+    void* new_end = paging_align_address(new_ptr + size);
+    memset(new_ptr + kept, 0x00, new_end - (new_ptr + kept));
+
+    int res = paging_map_to(process->task->page_directory, new_ptr, new_ptr, new_end, flags);
+    if (res < 0)
+    {
+        if (in_place)
+        {
+            if (new_end > old_end)
+            {
+                process_unmap_allocation(process, old_end, new_end - old_end);
+            }
+            kernel_resize_page_alloc(ptr, old_size);
+        }
+        else
+        {
+            process_unmap_allocation(process, new_ptr, size);
+            kernel_free_alloc(new_ptr);
+        }
+        return 0;
+    }
+
+    if (!in_place)
+    {
+        process_unmap_allocation(process, ptr, old_size);
+        kernel_free_alloc(ptr);
+    }
+    else if (new_end < old_end)
+    {
+        process_unmap_allocation(process, new_end, old_end - new_end);
+    }
+
+    allocation->ptr = new_ptr;
+    allocation->size = size;
+    return new_ptr;
+}
+
 // Loads a binary file into a process
 static int load_binary_file(const char* filename, struct Process* process)
 {
@@ -337,7 +628,7 @@ static int load_binary_file(const char* filename, struct Process* process)
         goto out;
     }
 
-    program_data_ptr = kernel_zeroed_alloc(stat.filesize);
+    program_data_ptr = vmalloc(stat.filesize);
     if (!program_data_ptr)
     {
         res = -ENOMEM;
@@ -357,10 +648,7 @@ static int load_binary_file(const char* filename, struct Process* process)
 out:
     if (res < 0)
     {
-        if (program_data_ptr)
-        {
-            kernel_free_alloc(program_data_ptr);
-        }
+        vfree(program_data_ptr);
     }
     fclose(fd);
     return res;
@@ -370,13 +658,72 @@ out:
 int process_map_binary(struct Process* process)
 {
     int res = 0;
-    paging_map_to(process->task->page_directory, (void*)USER_PROCESS_VIRTUAL_BASE_ADDRESS_NON_ELF, process->processBaseAddr,
-                  paging_align_address(process->processBaseAddr + process->size),
-                  PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE);
+    res = vmalloc_map_to(process->task->page_directory, (void*)USER_PROCESS_VIRTUAL_BASE_ADDRESS_NON_ELF,
+                         process->processBaseAddr, process->size,
+                         PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE | PAGING_IS_OWNED);
     return res;
 }
 
 
+/*
+Maps one PT_LOAD segment. The file part is mapped straight from the image, the bss past it is a demand zero region.
+The page where the file part ends is copied into a frame of the region with its tail zeroed, the image holds
+whatever the file has there.
+*/
+static int process_map_elf_segment(struct Process* process, struct Elf32Phdr* program_header, void* image,
+                                   int page_flags)
+{
+    int res = 0;
+    uint32_t vaddr = program_header->p_vaddr;
+    uint32_t file_end = vaddr + program_header->p_filesz;
+    uint32_t memory_end = (uint32_t)paging_align_address((void*)(vaddr + program_header->p_memsz));
+    bool has_bss = program_header->p_memsz > program_header->p_filesz;
+
+    // The image is vmalloc memory, each page is mapped to the frame behind it.
+    uint32_t mapped_start = (uint32_t)paging_align_to_lower_page((void*)vaddr);
+    uint32_t mapped_end = has_bss ? (uint32_t)paging_align_to_lower_page((void*)file_end) :
+                                    (uint32_t)paging_align_address((void*)file_end);
+    if (mapped_end > mapped_start)
+    {
+        res = vmalloc_map_to(process->task->page_directory, (void*)mapped_start,
+                             paging_align_to_lower_page(image), mapped_end - mapped_start,
+                             page_flags | PAGING_IS_OWNED);
+        if (res < 0)
+        {
+            goto out;
+        }
+    }
+
+    if (!has_bss)
+    {
+        goto out;
+    }
+
+    if (!process_add_region(process, mapped_end, memory_end, page_flags, PROCESS_REGION_ANONYMOUS))
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    uint32_t file_tail = file_end - mapped_end;
+    if (file_tail)
+    {
+        // A read fault, the segment may be read only and the kernel fills the frame through its identity mapping.
+        res = process_handle_page_fault(process, (void*)mapped_end, 0);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        void* frame = (void*)(paging_get(process->task->page_directory->directory_entry_ptr, (void*)mapped_end) &
+                              MASK_12_BITS_PAGE);
+        memcpy(frame, image + (mapped_end - vaddr), file_tail);
+    }
+
+out:
+    return res;
+}
+
 /**
  * 
  * Processes the PT_LOAD program header to map sections into memory.
@@ -409,6 +756,10 @@ static int process_map_loadable_elf_sections(struct Process* process)
     for (int i = 0; i < elf_header_ptr->e_phnum; i++)
     {
         struct Elf32Phdr* program_header = &program_headers[i];
+        if (program_header->p_type != PT_LOAD)
+        {
+            continue;
+        }
 
         void* program_header_physical_address = elf_program_header_physical_address(elf_file, program_header);
 
@@ -419,9 +770,7 @@ static int process_map_loadable_elf_sections(struct Process* process)
             page_flags |= PAGING_IS_WRITEABLE;
         }
 
-        res = paging_map_to(process->task->page_directory, paging_align_to_lower_page((void*)program_header->p_vaddr),
-                            paging_align_to_lower_page(program_header_physical_address),
-                            paging_align_address(program_header_physical_address + program_header->p_memsz), page_flags);
+        res = process_map_elf_segment(process, program_header, program_header_physical_address, page_flags);
         if (ISERR(res))
         {
             break;
@@ -430,6 +779,28 @@ static int process_map_loadable_elf_sections(struct Process* process)
     return res;
 }
 
+// The stack is demand paged. Its pages start out as the kernel's low memory in the shared page table, they are
+// cleared so the first touch faults.
+static int process_map_stack(struct Process* process)
+{
+    int res = paging_unmap_range(process->task->page_directory, (void*)USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE,
+                                 (USER_PROCESS_STACK_VIRTUAL_ADDRESS_END - USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE) /
+                                     PAGE_SIZE);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    if (!process_add_region(process, USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE, USER_PROCESS_STACK_VIRTUAL_ADDRESS_END,
+                            PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE,
+                            PROCESS_REGION_ANONYMOUS))
+    {
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
 // Maps the memory of a process based on its file type
 int process_map_memory(struct Process* process)
 {
@@ -454,14 +825,19 @@ int process_map_memory(struct Process* process)
         goto out;
     }
 
-    // Maps physical stack memory address with predefined stack virtual memory address.
-    paging_map_to(process->task->page_directory, 
-                (void*)USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE, process->stackPtr,
-                paging_align_address(process->stackPtr + USER_PROCESS_STACK_SIZE),
-                PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE);
+    res = process_map_stack(process);
+    if (res < 0)
+    {
+        goto out;
+    }
 
-    logAddress("stack: ", (unsigned long)process->stackPtr);
-    logAddress("process stack base (pre-defined): ", USER_PROCESS_STACK_VIRTUAL_ADDRESS_BASE);
+    // Empty until the first sbrk.
+    if (!process_add_region(process, USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE, USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE,
+                            PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE,
+                            PROCESS_REGION_ANONYMOUS))
+    {
+        res = -ENOMEM;
+    }
 
 out:
     return res;
@@ -524,7 +900,6 @@ int process_load_for_slot(const char* filename, struct Process** process, int pr
     int res = 0;
     struct Task* task = 0;
     struct Process* new_process_;
-    void* program_stack_ptr = 0;
 
     if (process_get(process_slot) != 0)
     {
@@ -546,18 +921,9 @@ int process_load_for_slot(const char* filename, struct Process** process, int pr
         goto out;
     }
 
-    program_stack_ptr = kernel_zeroed_alloc(USER_PROCESS_STACK_SIZE);
-    if (!program_stack_ptr)
-    {
-        res = -ENOMEM;
-        goto out;
-    }
-
     strncpy(new_process_->filename, filename, sizeof(new_process_->filename));
-    new_process_->stackPtr = program_stack_ptr;
     new_process_->processId = process_slot;
-
-    logAddress("stack allocated: ", (unsigned long)new_process_->stackPtr);
+    new_process_->heapBreak = USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE;
 
     // Create a new task
     task = task_new(new_process_);
@@ -619,4 +985,220 @@ int process_load_switch(const char* filename, struct Process** process)
     }
 
     return res;
-}
\ No newline at end of file
+}
+
+int process_fork(struct Process* parent, struct Process** child)
+{
+    int res = 0;
+    struct Process* new_process_ = 0;
+    struct Task* task = 0;
+
+    int process_slot = get_free_process_idx_from_buffer();
+    if (process_slot < 0)
+    {
+        res = -EISTKN;
+        goto out;
+    }
+
+    new_process_ = kernel_zeroed_alloc(sizeof(struct Process));
+    if (!new_process_)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // The arguments are in a region, process_malloc allocations are kernel heap memory and stay with the parent.
+    strncpy(new_process_->filename, parent->filename, sizeof(new_process_->filename));
+    new_process_->processId = process_slot;
+    new_process_->fileType = PROCESS_FILETYPE_FORK;
+    new_process_->size = parent->size;
+    new_process_->heapBreak = parent->heapBreak;
+    new_process_->processArguments = parent->processArguments;
+    memcpy(new_process_->regions, parent->regions, sizeof(new_process_->regions));
+
+    task = task_new(new_process_);
+    if (ISERR(task))
+    {
+        res = ERROR_I(task);
+        task = 0;
+        goto out;
+    }
+
+    new_process_->task = task;
+
+    res = paging_copy_user_mappings(parent->task->page_directory, task->page_directory);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // Shared memory and mapped files are mapped once more.
+    for (int i = 0; i < MAX_PROCESS_REGIONS; i++)
+    {
+        struct ProcessRegion* region = &new_process_->regions[i];
+        if (region->start && region->type == PROCESS_REGION_SHARED)
+        {
+            shm_ref(region->object);
+        }
+        else if (region->start && region->type == PROCESS_REGION_FILE)
+        {
+            page_cache_ref(region->object);
+        }
+    }
+
+    // The child resumes from the same syscall with 0 as its result.
+    task->registers = parent->task->registers;
+    task->registers.eax = 0;
+
+    *child = new_process_;
+    PROCESS_BUFFER_[process_slot] = new_process_;
+
+out:
+    if (ISERR(res))
+    {
+        if (task)
+        {
+            task_free(task);
+        }
+        kernel_free_alloc(new_process_);
+    }
+    return res;
+}
+
+int process_shm_map(struct Process* process, int segment_id, void** address)
+{
+    int res = 0;
+    int referenced = 0;
+    struct ShmSegment* segment = shm_get(segment_id);
+    if (!segment)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    uint32_t start = process_find_map_range(process, segment->size);
+    if (!start)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Each mapped page holds its own frame reference.
+    int total_pages = segment->size / PAGE_SIZE;
+    for (; referenced < total_pages; referenced++)
+    {
+        res = pmm_frame_ref(segment->frames + referenced * PAGE_SIZE);
+        if (res < 0)
+        {
+            goto out;
+        }
+    }
+
+    int flags = PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL | PAGING_IS_OWNED | PAGING_IS_SHARED;
+    struct ProcessRegion* region = process_add_region(process, start, start + segment->size, flags,
+                                                      PROCESS_REGION_SHARED);
+    if (!region)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+    region->object = segment_id;
+
+    res = paging_map_range(process->task->page_directory, (void*)start, segment->frames, total_pages, flags);
+    if (res < 0)
+    {
+        // Pages mapped before the failure drop their references with the unmap, the others here.
+        uint32_t* directory = process->task->page_directory->directory_entry_ptr;
+        for (int i = 0; i < total_pages; i++)
+        {
+            if (!(paging_get(directory, (void*)start + i * PAGE_SIZE) & PAGING_IS_PRESENT))
+            {
+                pmm_free_frame(segment->frames + i * PAGE_SIZE);
+            }
+        }
+        paging_unmap_range(process->task->page_directory, (void*)start, total_pages);
+        memset(region, 0, sizeof(struct ProcessRegion));
+        referenced = 0;
+        goto out;
+    }
+
+    shm_ref(segment_id);
+    *address = (void*)start;
+
+out:
+    if (res < 0)
+    {
+        for (int i = 0; i < referenced; i++)
+        {
+            pmm_free_frame(segment->frames + i * PAGE_SIZE);
+        }
+    }
+    return res;
+}
+
+// Unmaps a shared or file region that starts at address
+static int process_unmap_region(struct Process* process, void* address, uint8_t type)
+{
+    struct ProcessRegion* region = process_get_region(process, (uint32_t)address);
+    if (!region || region->type != type)
+    {
+        return -EINVARG;
+    }
+
+    int res = paging_unmap_range(process->task->page_directory, address, (region->end - region->start) / PAGE_SIZE);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    process_put_region_object(region);
+    memset(region, 0, sizeof(struct ProcessRegion));
+    return 0;
+}
+
+int process_shm_unmap(struct Process* process, void* address)
+{
+    return process_unmap_region(process, address, PROCESS_REGION_SHARED);
+}
+
+int process_mmap(struct Process* process, const char* path, void** address)
+{
+    int file_id = page_cache_open(path);
+    if (file_id < 0)
+    {
+        return file_id;
+    }
+
+    int res = 0;
+    uint32_t size = page_cache_get(file_id)->totalPages * PAGE_SIZE;
+    uint32_t start = process_find_map_range(process, size);
+    if (!start)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Read only, the pages are shared with every other mapping of the file.
+    struct ProcessRegion* region = process_add_region(process, start, start + size,
+                                                      PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL, PROCESS_REGION_FILE);
+    if (!region)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+    region->object = file_id;
+
+    *address = (void*)start;
+
+out:
+    if (res < 0)
+    {
+        page_cache_put(file_id);
+    }
+    return res;
+}
+
+int process_munmap(struct Process* process, void* address)
+{
+    return process_unmap_region(process, address, PROCESS_REGION_FILE);
+}
@@ -18,9 +18,30 @@
 // Process file type definitions
 #define PROCESS_FILETYPE_ELF 0 ///< ELF format.
 #define PROCESS_FILETYPE_BINARY 1 ///< Binary format, such as a.out.
+#define PROCESS_FILETYPE_FORK 2 ///< Forked copy, shares the parent's program pages and owns no program data.
 
 typedef unsigned char process_filetype_t; ///< Type for process file format.
 
+// Process memory region types
+#define PROCESS_REGION_ANONYMOUS 0 ///< Zero filled frames mapped on first touch (stack, heap, bss).
+#define PROCESS_REGION_SHARED 1 ///< Shared memory segment, mapped whole by process_shm_map.
+#define PROCESS_REGION_FILE 2 ///< Read only file, page cache frames mapped on first touch.
+
+/**
+ * @brief Range of a process's address space backed by PMM frames.
+ *
+ * Anonymous regions are demand paged, nothing is mapped up front and process_handle_page_fault maps a frame the first
+ * time a page is touched, file regions the same way with page cache frames. Every present page in a region holds a
+ * reference to its PMM frame (PAGING_IS_OWNED), forks share them copy-on-write, shared memory stays shared.
+ */
+struct ProcessRegion {
+    uint32_t start; ///< First page of the region, 0 when the slot is unused.
+    uint32_t end;   ///< End of the region, page aligned.
+    int flags;      ///< Page flags of the frames mapped in.
+    uint8_t type;   ///< PROCESS_REGION_ANONYMOUS, PROCESS_REGION_SHARED or PROCESS_REGION_FILE.
+    int object;     ///< Shared memory segment or page cache file id behind a shared or file region.
+};
+
 /**
  * @struct ProcessAllocation
  * @brief Represents a single memory allocation within a process.
@@ -68,10 +89,12 @@ struct Process {
         struct ElfFile *elfFile; ///< Pointer to ELF file structure if process is an ELF.
     };
 
-    void *stackPtr; ///< Pointer to the process's stack memory.
-
     uint32_t size; ///< Size of the process memory.
 
+    uint32_t heapBreak; ///< End of the user heap, starts at USER_PROCESS_HEAP_VIRTUAL_ADDRESS_BASE.
+
+    struct ProcessRegion regions[MAX_PROCESS_REGIONS]; ///< Demand paged stack, heap and bss.
+
     struct KeyboardBuffer { ///< Keyboard circular buffer for the process.
         char buffer[KEYBOARD_BUFFER_SIZE]; ///< Actual buffer.
         int tail; ///< Tail index for the circular buffer.
@@ -97,10 +120,89 @@ extern void *process_malloc(struct Process *process, size_t size);
 
 extern void process_free(struct Process *process, void *ptr);
 
+/**
+ * @brief Resizes a process_malloc allocation, growing it in place when the kernel heap allows.
+ *
+ * @return The new address, or 0 on failure with the old allocation left mapped.
+ */
+extern void *process_realloc(struct Process *process, void *ptr, size_t size);
+
+/**
+ * @brief Moves the end of the process's user heap by increment bytes.
+ *
+ * Pages entering the heap are backed by zeroed PMM frames, pages leaving it are unmapped and their frames freed.
+ *
+ * @return The previous heap end, or 0 if the heap can't grow or shrink that far.
+ */
+extern void *process_sbrk(struct Process *process, int increment);
+
 extern void process_get_arguments(struct Process *process, int *argc, char ***argv);
 
 extern int process_inject_arguments(struct Process *process, struct CommandArgument *root_argument);
 
 extern int process_terminate(struct Process *process);
 
+/**
+ * @brief Maps a zeroed frame at a not present page of one of the process's regions, or copies a copy-on-write page
+ * that is written to.
+ *
+ * @param process Process whose address space faulted.
+ * @param address Faulting virtual address (CR2).
+ * @param error_code Page fault error code, PAGING_FAULT_PRESENT and PAGING_FAULT_WRITE are looked at.
+ * @return int 0 when the access can be retried, -EFAULT outside every region or on a protection violation, -ENOMEM.
+ */
+extern int process_handle_page_fault(struct Process *process, void *address, uint32_t error_code);
+
+/**
+ * @brief Creates a copy of a process whose task resumes at the same point with eax = 0.
+ *
+ * The address space is shared copy-on-write, the program arguments and the user heap included.
+ *
+ * @param parent Process to copy, its task registers must hold the state to resume from.
+ * @param child Set to the new process on success.
+ * @return int 0 on success, -EISTKN when every process slot is taken, -ENOMEM.
+ */
+extern int process_fork(struct Process *parent, struct Process **child);
+
+/**
+ * @brief Maps a whole shared memory segment into the process, first fit in the mapping window.
+ *
+ * @param process Process to map the segment into.
+ * @param segment Segment id from shm_create.
+ * @param address Set to the user address of the segment on success.
+ * @return int 0 on success, -EINVARG for an unknown segment, -ENOMEM when the window or the regions are full.
+ */
+extern int process_shm_map(struct Process *process, int segment, void **address);
+
+/**
+ * @brief Unmaps a shared memory segment, it is freed once no mapping is left and its creator exited.
+ *
+ * @param process Process that mapped the segment.
+ * @param address Address process_shm_map returned.
+ * @return int 0 on success, -EINVARG when no segment is mapped there.
+ */
+extern int process_shm_unmap(struct Process *process, void *address);
+
+/**
+ * @brief Maps a whole file read only, first fit in the mapping window.
+ *
+ * Nothing is read up front, each page comes from the page cache on first touch and is shared with every other
+ * mapping of the same file, whatever path it was opened by.
+ *
+ * @param process Process to map the file into.
+ * @param path Full path of the file, e.g. 0:/data.bin.
+ * @param address Set to the user address of the file on success.
+ * @return int 0 on success, -EIO when the file can't be opened, -EINVARG for an empty file, -ENOMEM.
+ */
+extern int process_mmap(struct Process *process, const char *path, void **address);
+
+/**
+ * @brief Unmaps a file mapped with process_mmap, the page cache drops it with its last mapping.
+ *
+ * @param process Process that mapped the file.
+ * @param address Address process_mmap returned.
+ * @return int 0 on success, -EINVARG when no file is mapped there.
+ */
+extern int process_munmap(struct Process *process, void *address);
+
 #endif // PROCESS_H
\ No newline at end of file
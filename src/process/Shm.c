@@ -0,0 +1,107 @@
+#include "Shm.h"
+#include "Status.h"
+#include "memory/Memory.h"
+#include "paging/Paging.h"
+#include "pmm/Pmm.h"
+#include "vga/Vga.h"
+
+static struct ShmSegment SHM_SEGMENTS_[MAX_SHM_SEGMENTS] = {};
+
+// Gives the table's frame references back, mapped frames live on until their pages are unmapped.
+static void shm_free(struct ShmSegment* segment)
+{
+    for (uint32_t offset = 0; offset < segment->size; offset += PAGE_SIZE)
+    {
+        pmm_free_frame(segment->frames + offset);
+    }
+
+    memset(segment, 0, sizeof(struct ShmSegment));
+}
+
+int shm_create(size_t size, int creator_id)
+{
+    if (size == 0 || size > USER_PROCESS_MAP_MAX_SIZE)
+    {
+        return -EINVARG;
+    }
+
+    for (int i = 0; i < MAX_SHM_SEGMENTS; i++)
+    {
+        struct ShmSegment* segment = &SHM_SEGMENTS_[i];
+        if (segment->frames)
+        {
+            continue;
+        }
+
+        uint32_t total_bytes = (uint32_t)paging_align_address((void*)size);
+        void* frames = pmm_alloc_frames(total_bytes / PAGE_SIZE);
+        if (!frames)
+        {
+            return -ENOMEM;
+        }
+
+        memset(frames, 0x00, total_bytes);
+        segment->frames = frames;
+        segment->size = total_bytes;
+        segment->mappings = 0;
+        segment->creatorId = creator_id;
+        return i;
+    }
+
+    log("Error: shm_create no free segment");
+    return -ENOMEM;
+}
+
+struct ShmSegment* shm_get(int id)
+{
+    if (id < 0 || id >= MAX_SHM_SEGMENTS || !SHM_SEGMENTS_[id].frames)
+    {
+        return 0;
+    }
+
+    return &SHM_SEGMENTS_[id];
+}
+
+void shm_ref(int id)
+{
+    struct ShmSegment* segment = shm_get(id);
+    if (segment)
+    {
+        segment->mappings++;
+    }
+}
+
+void shm_put(int id)
+{
+    struct ShmSegment* segment = shm_get(id);
+    if (!segment)
+    {
+        return;
+    }
+
+    // The creator may still map it again by id.
+    segment->mappings--;
+    if (segment->mappings <= 0 && segment->creatorId == -1)
+    {
+        shm_free(segment);
+    }
+}
+
+void shm_release_creator(int creator_id)
+{
+    for (int i = 0; i < MAX_SHM_SEGMENTS; i++)
+    {
+        struct ShmSegment* segment = &SHM_SEGMENTS_[i];
+        if (!segment->frames || segment->creatorId != creator_id)
+        {
+            continue;
+        }
+
+        // Process ids are reused, the segment no longer has a creator.
+        segment->creatorId = -1;
+        if (segment->mappings == 0)
+        {
+            shm_free(segment);
+        }
+    }
+}
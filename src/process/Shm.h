@@ -0,0 +1,38 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+/*
+Shared memory segments : a physically contiguous run of PMM frames that several processes map at once.
+
+Every mapped page holds a reference to its frame (PAGING_IS_OWNED) and stays shared across fork (PAGING_IS_SHARED).
+The segment table holds one more reference per frame until the segment is freed, once its creator exited and no
+mapping is left.
+*/
+
+struct ShmSegment {
+    void *frames;   ///< First frame of the run, 0 when the slot is unused.
+    uint32_t size;  ///< Page aligned size.
+    int mappings;   ///< Process regions that map the segment, forks included.
+    int creatorId;  ///< Process that created the segment, -1 once it exited.
+};
+
+// Allocates and zeroes a segment of size bytes (page aligned up), the segment id or -EINVARG, -ENOMEM.
+extern int shm_create(size_t size, int creator_id);
+
+// Segment of id, 0 when it doesn't exist.
+extern struct ShmSegment *shm_get(int id);
+
+// Counts one more mapping of the segment, the caller maps its frames.
+extern void shm_ref(int id);
+
+// Drops one mapping, the last one frees the segment when its creator already exited.
+extern void shm_put(int id);
+
+// The creator exited, its segments without a mapping are freed.
+extern void shm_release_creator(int creator_id);
+
+#endif
@@ -16,10 +16,117 @@ struct Task* TASK_FRONT_ = 0;
 struct Task* TASK_TAIL_ = 0;
 
 
-// Function to convert a virtual address in a task's address space to a physical address
-void* task_virtual_address_to_physical(struct Task* task, void* virtual_address)
+/*
+User memory access. Each user page is translated once through the task's page tables and copied through the
+kernel's identity mapping of its frame, no allocation and no CR3 switch, the task needn't be the loaded one.
+Demand paged pages get their frame on the way, copy-on-write pages are copied before the kernel writes to them.
+*/
+
+// Kernel address of virt's byte in its frame, 0 when the task can't access the page (or can't write it).
+static void* task_user_address(struct Task* task, void* virt, bool write)
 {
-    return paging_get_physical_address(task->page_directory->directory_entry_ptr, virtual_address);
+    uint32_t* directory = task->page_directory->directory_entry_ptr;
+    void* page = paging_align_to_lower_page(virt);
+    uint32_t entry = paging_get(directory, page);
+    if (!(entry & PAGING_IS_PRESENT) || (write && (entry & PAGING_IS_COW)))
+    {
+        uint32_t error_code = (entry & PAGING_IS_PRESENT ? PAGING_FAULT_PRESENT : 0) | (write ? PAGING_FAULT_WRITE : 0);
+        if (process_handle_page_fault(task->process, virt, error_code) < 0)
+        {
+            return 0;
+        }
+        entry = paging_get(directory, page);
+    }
+
+    if (!(entry & PAGING_IS_PRESENT) || !(entry & PAGING_ACCESS_FROM_ALL) || (write && !(entry & PAGING_IS_WRITEABLE)))
+    {
+        return 0;
+    }
+
+    return (void*)((entry & MASK_12_BITS_PAGE) + (virt - page));
+}
+
+// Bytes from virt to the end of its page, at most size.
+static size_t task_user_chunk(void* virt, size_t size)
+{
+    size_t chunk = PAGE_SIZE - (uint32_t)virt % PAGE_SIZE;
+    return chunk < size ? chunk : size;
+}
+
+int copy_from_user(struct Task* task, void* dst, const void* user_src, size_t size)
+{
+    void* src = (void*)user_src;
+    while (size)
+    {
+        size_t chunk = task_user_chunk(src, size);
+        void* from = task_user_address(task, src, false);
+        if (!from)
+        {
+            return -EFAULT;
+        }
+
+        memcpy(dst, from, chunk);
+        dst += chunk;
+        src += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+int copy_to_user(struct Task* task, void* user_dst, const void* src, size_t size)
+{
+    while (size)
+    {
+        size_t chunk = task_user_chunk(user_dst, size);
+        void* to = task_user_address(task, user_dst, true);
+        if (!to)
+        {
+            return -EFAULT;
+        }
+
+        memcpy(to, (void*)src, chunk);
+        user_dst += chunk;
+        src += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+int strncpy_from_user(struct Task* task, char* dst, const char* user_src, int max)
+{
+    if (max <= 0)
+    {
+        return -EINVARG;
+    }
+
+    // The last byte of dst is kept for the terminator.
+    int length = 0;
+    char* src = (char*)user_src;
+    while (length < max - 1)
+    {
+        int chunk = task_user_chunk(src, max - 1 - length);
+        char* from = task_user_address(task, src, false);
+        if (!from)
+        {
+            dst[length] = 0;
+            return -EFAULT;
+        }
+
+        for (int i = 0; i < chunk; i++, length++)
+        {
+            dst[length] = from[i];
+            if (!from[i])
+            {
+                return length;
+            }
+        }
+        src += chunk;
+    }
+
+    dst[length] = 0;
+    return length;
 }
 
 
@@ -78,44 +185,6 @@ void task_save_state(struct Task* task, struct InterruptFrame* frame)
     task->registers.esi = frame->esi;
 }
 
-// Function to copy a string from one task to another, handling virtual to physical address mapping
-int copy_string_from_task(struct Task* task, void* virtual, void* phys, int max)
-{
-    if (max >= PAGE_SIZE)
-    {
-        return -EINVARG;
-    }
-
-    int res = 0;
-    char* tmp = kernel_zeroed_alloc(max);
-    if (!tmp)
-    {
-        res = -ENOMEM;
-        goto out;
-    }
-
-    uint32_t* task_directory = task->page_directory->directory_entry_ptr;
-    uint32_t old_entry = paging_get(task_directory, tmp);
-    map_virtual_address_to_physical_address(task->page_directory, tmp, tmp, PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
-    set_current_page_directory(task->page_directory);
-    strncpy(tmp, virtual, max);
-    kernel_page();
-
-    res = paging_set(task_directory, tmp, old_entry);
-    if (res < 0)
-    {
-        res = -EIO;
-        goto out_free;
-    }
-
-    strncpy(phys, tmp, max);
-
-out_free:
-    kernel_free_alloc(tmp);
-out:
-    return res;
-}
-
 // Function to save the state of the current task
 void task_current_save_state(struct InterruptFrame* frame)
 {
@@ -128,38 +197,12 @@ void task_current_save_state(struct InterruptFrame* frame)
     task_save_state(task, frame);
 }
 
-// Function to switch the page directory to the current task's page directory
-int task_page()
-{
-    user_registers();
-    set_current_task(CURRENT_TASK_);
-    return 0;
-}
-
-// Function to switch the page directory to a specified task's page directory
-int task_page_task(struct Task* task)
-{
-    user_registers();
-    set_current_page_directory(task->page_directory);
-    return 0;
-}
-
-// Function to get a specific item from a task's stack
+// Function to get a specific item from a task's stack, 0 when the task's stack isn't readable there
 void* task_get_stack_item(struct Task* task, int index)
 {
-    void* result = 0;
-
-    uint32_t* sp_ptr = (uint32_t*)task->registers.esp;
-
-    // Switch to the given tasks page
-    task_page_task(task);
-
-    result = (void*)sp_ptr[index];
-
-    // Switch back to the kernel page
-    kernel_page();
-
-    return result;
+    uint32_t item = 0;
+    copy_from_user(task, &item, (uint32_t*)task->registers.esp + index, sizeof(item));
+    return (void*)item;
 }
 
 
@@ -192,7 +235,14 @@ static void remove_task_from_list(struct Task* task)
 
 int task_free(struct Task* task)
 {
+    // An exiting task frees its own directory from its syscall, move off it before the memory is reused.
+    if (paging_current_directory() == task->page_directory)
+    {
+        kernel_page();
+    }
+
     paging_free_4gb(task->page_directory);
+    arena_release(&task->scratch);
     remove_task_from_list(task);
 
     kernel_free_alloc(task);
@@ -217,13 +267,18 @@ int task_init(struct Task* task, struct Process* process)
     memset(task, 0, sizeof(struct Task));
 
     // allocate page directory for the task
-    task->page_directory = new_page_directory_allocation(PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+    task->page_directory = new_page_directory_allocation();
 
     if (!task->page_directory)
     {
         return -EIO;
     }
 
+    if (arena_init(&task->scratch, KERNEL_SCRATCH_ARENA_SIZE) < 0)
+    {
+        return -ENOMEM;
+    }
+
     task->registers.ip = USER_PROCESS_VIRTUAL_BASE_ADDRESS_NON_ELF;
     
     if (process->fileType == PROCESS_FILETYPE_ELF)
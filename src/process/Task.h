@@ -12,6 +12,7 @@
 
 #include "Config.h"
 #include "paging/Paging.h"
+#include "malloc/Arena.h"
 
 struct InterruptFrame; ///< Forward declaration for interrupt frame structure.
 struct Process; ///< Forward declaration for process structure.
@@ -41,6 +42,7 @@ struct Task {
     struct Process *process; ///< Associated process.
     struct Task *next; ///< Next task in the task list.
     struct Task *prev; ///< Previous task in the task list.
+    struct Arena scratch; ///< Scratch arena for kernel temporaries while serving this task.
 };
 
 
@@ -56,10 +58,6 @@ extern int task_free(struct Task *task);
 
 extern int set_current_task(struct Task *task);
 
-extern int task_page();
-
-extern int task_page_task(struct Task *task);
-
 extern void run_first_task();
 
 extern void task_return(struct Registers *regs);
@@ -70,11 +68,36 @@ extern void user_registers();
 
 extern void task_current_save_state(struct InterruptFrame *frame);
 
-extern int copy_string_from_task(struct Task *task, void *virtual, void *phys, int max);
+/**
+ * @brief Copies size bytes from a task's user memory.
+ *
+ * Page by page through the kernel mapping of the frames, demand paged pages are faulted in. Neither allocates nor
+ * reloads CR3, the task needn't be the current one.
+ *
+ * @return int 0 on success, -EFAULT when a page isn't user readable, dst may then be partly written.
+ */
+extern int copy_from_user(struct Task *task, void *dst, const void *user_src, size_t size);
 
-extern void *task_get_stack_item(struct Task *task, int index);
+/**
+ * @brief Copies size bytes into a task's user memory, copy-on-write pages are copied first.
+ *
+ * @return int 0 on success, -EFAULT when a page isn't user writable, the pages before it are written.
+ */
+extern int copy_to_user(struct Task *task, void *user_dst, const void *src, size_t size);
+
+/**
+ * @brief Copies a string from a task's user memory, at most max - 1 characters, dst is always terminated.
+ *
+ * @return int Length of the copied string, -EFAULT when a page isn't user readable before the terminator.
+ */
+extern int strncpy_from_user(struct Task *task, char *dst, const char *user_src, int max);
 
-extern void *task_virtual_address_to_physical(struct Task *task, void *virtual_address);
+/**
+ * @brief Reads the index'th 32 bit item of a task's user stack, the syscall arguments.
+ *
+ * @return void* The item, 0 when the stack isn't readable there.
+ */
+extern void *task_get_stack_item(struct Task *task, int index);
 
 extern void run_next_task();
 
@@ -0,0 +1,374 @@
+#include "Heap.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+Randomized alloc/free traces against src/malloc/Heap.c on a malloc'd arena.
+
+For every trace and policy/encoding pair the heap is recreated, driven to the target fill with a mix of allocations
+and frees, then emptied again. Reported per run:
+
+alloc/free ns   : mean wall time per heap_malloc / heap_free, measured per call with CLOCK_MONOTONIC.
+worst ns        : slowest single heap_malloc.
+frag %          : 1 - largest free run / free blocks, averaged over samples and at the end of the trace.
+scan            : map entries examined per heap_malloc (HEAP_SCAN_COUNT), mean and worst case.
+
+Each allocation is tagged at both ends and checked when freed, a heap that hands out overlapping runs or doesn't
+return to empty fails the run.
+*/
+
+#define BENCH_DEFAULT_OPERATIONS 200000
+#define BENCH_DEFAULT_BLOCKS 16384 // 64MB heap
+#define BENCH_DEFAULT_FILL_PERCENT 75
+#define BENCH_DEFAULT_SEED 1
+#define BENCH_SAMPLE_INTERVAL 1024
+
+struct BenchTrace {
+    const char *name_;
+    uint32_t minBlocks_;
+    uint32_t maxBlocks_;
+};
+
+struct BenchConfig {
+    const char *name_;
+    int policy_;
+    int encoding_;
+};
+
+struct BenchResult {
+    uint64_t allocNs_;
+    uint64_t freeNs_;
+    uint64_t worstAllocNs_;
+    uint32_t allocations_;
+    uint32_t frees_;
+    uint32_t failures_;
+    uint64_t scanTotal_;
+    uint32_t scanWorst_;
+    double fragmentationTotal_;
+    uint32_t fragmentationSamples_;
+    double endFragmentation_;
+    int corrupted_;
+};
+
+struct BenchAllocation {
+    uint32_t *ptr_;
+    size_t size_;
+    uint32_t tag_;
+};
+
+static const struct BenchTrace TRACES_[] = {
+    {"small", 1, 4},
+    {"mixed", 1, 64},
+    {"large", 16, 512},
+};
+
+// Buddy needs the bytemap, see heap_create.
+static const struct BenchConfig CONFIGS_[] = {
+    {"first-fit/bytemap", HEAP_POLICY_FIRST_FIT, HEAP_MAP_ENCODING_BYTEMAP},
+    {"first-fit/bitmap", HEAP_POLICY_FIRST_FIT, HEAP_MAP_ENCODING_BITMAP},
+    {"next-fit/bytemap", HEAP_POLICY_NEXT_FIT, HEAP_MAP_ENCODING_BYTEMAP},
+    {"next-fit/bitmap", HEAP_POLICY_NEXT_FIT, HEAP_MAP_ENCODING_BITMAP},
+    {"cached/bytemap", HEAP_POLICY_CACHED, HEAP_MAP_ENCODING_BYTEMAP},
+    {"cached/bitmap", HEAP_POLICY_CACHED, HEAP_MAP_ENCODING_BITMAP},
+    {"buddy/bytemap", HEAP_POLICY_BUDDY, HEAP_MAP_ENCODING_BYTEMAP},
+};
+
+static int BENCH_VERBOSE_ = 0;
+static uint32_t BENCH_RANDOM_STATE_ = BENCH_DEFAULT_SEED;
+
+void log(const char *msg)
+{
+    if (BENCH_VERBOSE_)
+    {
+        fprintf(stderr, "%s\n", msg);
+    }
+}
+
+void logAddress(const char *msg, const unsigned long addr)
+{
+    if (BENCH_VERBOSE_)
+    {
+        fprintf(stderr, "%s%lx\n", msg, addr);
+    }
+}
+
+void panic(const char *msg)
+{
+    fprintf(stderr, "panic: %s\n", msg);
+    exit(2);
+}
+
+// xorshift32, traces are reproducible for a given seed.
+static uint32_t bench_random()
+{
+    uint32_t x = BENCH_RANDOM_STATE_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    BENCH_RANDOM_STATE_ = x;
+    return x;
+}
+
+static uint64_t bench_now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Log-uniform block count in [min, max] so small sizes dominate, minus a random tail of the last block that leaves
+// room for the start and end tags.
+static size_t bench_random_size(const struct BenchTrace *trace)
+{
+    uint32_t blocks = trace->minBlocks_;
+    uint32_t range = trace->maxBlocks_ / trace->minBlocks_;
+    int max_shift = 0;
+    while ((1U << (max_shift + 1)) <= range)
+    {
+        max_shift++;
+    }
+
+    blocks <<= bench_random() % (max_shift + 1);
+    blocks += bench_random() % blocks;
+    if (blocks > trace->maxBlocks_)
+    {
+        blocks = trace->maxBlocks_;
+    }
+
+    return (size_t)blocks * HEAP_BLOCK_SIZE - bench_random() % (HEAP_BLOCK_SIZE - 2 * sizeof(uint32_t));
+}
+
+static double bench_fragmentation(struct Heap *heap)
+{
+    struct HeapStats stats;
+    heap_get_stats(heap, &stats);
+    if (stats.freeBlocks_ == 0)
+    {
+        return 0.0;
+    }
+
+    return 1.0 - (double)stats.largestFreeRun_ / stats.freeBlocks_;
+}
+
+static void bench_tag(struct BenchAllocation *allocation)
+{
+    allocation->ptr_[0] = allocation->tag_;
+    allocation->ptr_[allocation->size_ / sizeof(uint32_t) - 1] = ~allocation->tag_;
+}
+
+static int bench_tag_intact(struct BenchAllocation *allocation)
+{
+    return allocation->ptr_[0] == allocation->tag_ &&
+           allocation->ptr_[allocation->size_ / sizeof(uint32_t) - 1] == ~allocation->tag_;
+}
+
+static void bench_free(struct Heap *heap, struct BenchAllocation *allocation, struct BenchResult *result)
+{
+    if (!bench_tag_intact(allocation))
+    {
+        result->corrupted_ = 1;
+    }
+
+    uint64_t start = bench_now_ns();
+    heap_free(heap, allocation->ptr_);
+    result->freeNs_ += bench_now_ns() - start;
+    result->frees_++;
+}
+
+static int bench_run(const struct BenchTrace *trace, const struct BenchConfig *config, size_t total_blocks,
+                     uint32_t operations, uint32_t fill_percent, struct BenchResult *result)
+{
+    memset(result, 0, sizeof(struct BenchResult));
+
+    struct HeapMap map;
+    memset(&map, 0, sizeof(map));
+    map.encoding_ = config->encoding_;
+    map.totalEntries_ = total_blocks;
+    map.mapBaseAddress_ = malloc(heap_map_storage_size(config->encoding_, total_blocks));
+
+    void *arena = 0;
+    struct BenchAllocation *live = calloc(total_blocks, sizeof(struct BenchAllocation));
+    if (posix_memalign(&arena, HEAP_BLOCK_SIZE, total_blocks * HEAP_BLOCK_SIZE) != 0 || !map.mapBaseAddress_ || !live)
+    {
+        fprintf(stderr, "heap_bench: out of host memory\n");
+        exit(2);
+    }
+
+    struct Heap heap;
+    if (heap_create(&heap, arena, arena + total_blocks * HEAP_BLOCK_SIZE, &map, config->policy_) < 0)
+    {
+        fprintf(stderr, "heap_bench: heap_create failed for %s\n", config->name_);
+        exit(2);
+    }
+
+    size_t target_blocks = total_blocks * fill_percent / 100;
+    size_t live_blocks = 0;
+    size_t live_count = 0;
+
+    for (uint32_t op = 0; op < operations; op++)
+    {
+        // Allocate towards the target fill, one in four operations frees anyway so runs keep moving.
+        int allocate = live_count == 0 || (live_blocks < target_blocks && bench_random() % 4 != 0);
+        if (allocate)
+        {
+            size_t size = bench_random_size(trace);
+
+            HEAP_SCAN_LENGTH_ = 0;
+            uint64_t start = bench_now_ns();
+            void *ptr = heap_malloc(&heap, size);
+            uint64_t elapsed = bench_now_ns() - start;
+
+            result->allocNs_ += elapsed;
+            result->allocations_++;
+            result->scanTotal_ += HEAP_SCAN_LENGTH_;
+            if (HEAP_SCAN_LENGTH_ > result->scanWorst_)
+            {
+                result->scanWorst_ = HEAP_SCAN_LENGTH_;
+            }
+            if (elapsed > result->worstAllocNs_)
+            {
+                result->worstAllocNs_ = elapsed;
+            }
+
+            if (!ptr)
+            {
+                result->failures_++;
+            }
+            else
+            {
+                struct BenchAllocation *allocation = &live[live_count++];
+                allocation->ptr_ = ptr;
+                allocation->size_ = size & ~(sizeof(uint32_t) - 1);
+                allocation->tag_ = bench_random();
+                bench_tag(allocation);
+                live_blocks += (size + HEAP_BLOCK_SIZE - 1) / HEAP_BLOCK_SIZE;
+            }
+        }
+        else
+        {
+            size_t index = bench_random() % live_count;
+            live_blocks -= (live[index].size_ + HEAP_BLOCK_SIZE - 1) / HEAP_BLOCK_SIZE;
+            bench_free(&heap, &live[index], result);
+            live[index] = live[--live_count];
+        }
+
+        if (op % BENCH_SAMPLE_INTERVAL == BENCH_SAMPLE_INTERVAL - 1)
+        {
+            result->fragmentationTotal_ += bench_fragmentation(&heap);
+            result->fragmentationSamples_++;
+        }
+    }
+
+    result->endFragmentation_ = bench_fragmentation(&heap);
+
+    while (live_count > 0)
+    {
+        bench_free(&heap, &live[--live_count], result);
+    }
+
+    struct HeapStats stats;
+    heap_get_stats(&heap, &stats);
+    int res = result->corrupted_ || stats.usedBlocks_ != 0 || stats.largestFreeRun_ != total_blocks ? -1 : 0;
+
+    free(live);
+    free(arena);
+    free(map.mapBaseAddress_);
+    return res;
+}
+
+static void bench_print(const struct BenchTrace *trace, const struct BenchConfig *config, struct BenchResult *result,
+                        int res)
+{
+    double samples = result->fragmentationSamples_ ? result->fragmentationSamples_ : 1;
+    printf("%-6s %-18s %9.1f %9.1f %10llu %8u %7.1f %7.1f %9.1f %8u  %s\n", trace->name_, config->name_,
+           result->allocations_ ? (double)result->allocNs_ / result->allocations_ : 0.0,
+           result->frees_ ? (double)result->freeNs_ / result->frees_ : 0.0,
+           (unsigned long long)result->worstAllocNs_, result->failures_,
+           100.0 * result->fragmentationTotal_ / samples, 100.0 * result->endFragmentation_,
+           result->allocations_ ? (double)result->scanTotal_ / result->allocations_ : 0.0, result->scanWorst_,
+           res < 0 ? "FAIL" : "ok");
+}
+
+static void bench_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-n operations] [-b heap blocks] [-f fill percent] [-s seed] [-t trace] [-v]\n"
+            "traces: small, mixed, large (default all)\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t operations = BENCH_DEFAULT_OPERATIONS;
+    size_t total_blocks = BENCH_DEFAULT_BLOCKS;
+    uint32_t fill_percent = BENCH_DEFAULT_FILL_PERCENT;
+    uint32_t seed = BENCH_DEFAULT_SEED;
+    const char *trace_name = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:b:f:s:t:v")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            operations = strtoul(optarg, 0, 0);
+            break;
+        case 'b':
+            total_blocks = strtoul(optarg, 0, 0);
+            break;
+        case 'f':
+            fill_percent = strtoul(optarg, 0, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, 0, 0);
+            break;
+        case 't':
+            trace_name = optarg;
+            break;
+        case 'v':
+            BENCH_VERBOSE_ = 1;
+            break;
+        default:
+            bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (total_blocks == 0 || fill_percent == 0 || fill_percent > 100 || seed == 0)
+    {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("operations %u, heap %zu blocks (%zu KB), fill %u%%, seed %u\n\n", operations, total_blocks,
+           total_blocks * HEAP_BLOCK_SIZE / 1024, fill_percent, seed);
+    printf("%-6s %-18s %9s %9s %10s %8s %7s %7s %9s %8s\n", "trace", "heap", "alloc ns", "free ns", "worst ns",
+           "failed", "frag %", "end %", "scan", "worst");
+
+    int failed = 0;
+    for (size_t t = 0; t < sizeof(TRACES_) / sizeof(TRACES_[0]); t++)
+    {
+        if (trace_name && strcmp(trace_name, TRACES_[t].name_) != 0)
+        {
+            continue;
+        }
+
+        for (size_t c = 0; c < sizeof(CONFIGS_) / sizeof(CONFIGS_[0]); c++)
+        {
+            // Same trace for every heap.
+            BENCH_RANDOM_STATE_ = seed;
+
+            struct BenchResult result;
+            int res = bench_run(&TRACES_[t], &CONFIGS_[c], total_blocks, operations, fill_percent, &result);
+            bench_print(&TRACES_[t], &CONFIGS_[c], &result, res);
+            failed |= res < 0;
+        }
+        printf("\n");
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,9 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// Host stand-in for src/memory/Memory.h, the heap only needs the libc string functions.
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+// Host stand-in for src/vga/Vga.h, implemented by heap_bench.c.
+
+extern void panic(const char *msg);
+
+extern void log(const char *msg);
+
+extern void logAddress(const char *msg, const unsigned long addr);
+
+#endif